@@ -0,0 +1,176 @@
+/*
+ * Copyright (c) 2020 Fraunhofer FOKUS and others. All rights reserved.
+ *
+ * Contact: mosaic@fokus.fraunhofer.de
+ *
+ * This class is developed for the MOSAIC-NS-3 coupling.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+
+/**
+ * Compares the protobuf encoding of the frequent messages with the fixed layout codec.
+ * Every iteration encodes a command and its body into a buffer, as the channel does before
+ * send, and decodes them again. Prints the time per message and the encoded size.
+ *
+ * usage: codec-benchmark [iterations]
+ */
+
+#include "ClientServerChannelMessages.pb.h"
+#include "ClientServerChannelFixedCodec.h"
+
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/io/zero_copy_stream_impl_lite.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+using namespace ClientServerChannelSpace;
+
+namespace {
+
+    // keeps the compiler from dropping the decoded results
+    volatile int64_t g_sink = 0;
+
+    size_t EncodeProtobuf(const google::protobuf::Message &message, std::vector<char> &buffer, size_t offset) {
+        const size_t size = message.ByteSizeLong();
+        if (size > std::numeric_limits<uint32_t>::max()) {
+            std::cerr << message.GetTypeName() << " exceeds the frame limit" << std::endl;
+            std::exit(1);
+        }
+        const size_t frameSize = google::protobuf::io::CodedOutputStream::VarintSize32(static_cast<uint32_t> (size)) + size;
+        {
+            google::protobuf::io::ArrayOutputStream arrayOut(buffer.data() + offset, frameSize);
+            google::protobuf::io::CodedOutputStream codedOut(&arrayOut);
+            codedOut.WriteVarint32(size);
+            message.SerializeWithCachedSizes(&codedOut);
+        }
+        return frameSize;
+    }
+
+    size_t DecodeProtobuf(google::protobuf::Message &message, const std::vector<char> &buffer, size_t offset) {
+        google::protobuf::io::CodedInputStream codedIn(reinterpret_cast<const uint8_t*> (buffer.data() + offset), buffer.size() - offset);
+        uint32_t size = 0;
+        codedIn.ReadVarint32(&size);
+        const google::protobuf::io::CodedInputStream::Limit limit = codedIn.PushLimit(size);
+        message.ParseFromCodedStream(&codedIn);
+        codedIn.PopLimit(limit);
+        return codedIn.CurrentPosition();
+    }
+
+    template<typename Function>
+    void Report(const std::string &name, size_t iterations, Function function) {
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations; i++) {
+            function(i);
+        }
+        const double elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        std::cout << name << ": " << elapsed / iterations << " ns/message" << std::endl;
+    }
+}
+
+int main(int argc, char **argv) {
+    const size_t iterations = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+    std::vector<char> buffer(256);
+
+    CommandMessage command;
+    TimeMessage time;
+    ReceiveMessage receive;
+    SendMessageMessage send;
+    size_t bytes = 0;
+
+    Report("protobuf command + time", iterations, [&](size_t i) {
+        command.set_command_type(CommandMessage_CommandType_NEXT_EVENT);
+        time.set_time(1000000000LL + i);
+        time.set_lookahead(40000);
+        size_t offset = EncodeProtobuf(command, buffer, 0);
+        bytes = offset + EncodeProtobuf(time, buffer, offset);
+        offset = DecodeProtobuf(command, buffer, 0);
+        DecodeProtobuf(time, buffer, offset);
+        g_sink += command.command_type() + time.time();
+    });
+    std::cout << "  encoded size: " << bytes << " bytes" << std::endl;
+
+    Report("fixed    command + time", iterations, [&](size_t i) {
+        FixedCodec::encodeCommand(buffer.data(), CommandMessage_CommandType_NEXT_EVENT);
+        FixedCodec::encode(buffer.data() + FixedCodec::COMMAND_SIZE, FixedCodec::TimeMessage { static_cast<int64_t> (1000000000LL + i), 40000 });
+        FixedCodec::TimeMessage decoded;
+        const int32_t decodedCommand = FixedCodec::decodeCommand(buffer.data());
+        FixedCodec::decode(buffer.data() + FixedCodec::COMMAND_SIZE, decoded);
+        g_sink += decodedCommand + decoded.time;
+    });
+    std::cout << "  encoded size: " << FixedCodec::COMMAND_SIZE + FixedCodec::TIME_MESSAGE_SIZE << " bytes" << std::endl;
+
+    Report("protobuf command + receive", iterations, [&](size_t i) {
+        command.set_command_type(CommandMessage_CommandType_MSG_RECV);
+        receive.set_time(1000000000LL + i);
+        receive.set_node_id(i & 0xffff);
+        receive.set_message_id(i);
+        receive.set_channel_id(PROTO_CCH);
+        receive.set_rssi(-80);
+        size_t offset = EncodeProtobuf(command, buffer, 0);
+        bytes = offset + EncodeProtobuf(receive, buffer, offset);
+        offset = DecodeProtobuf(command, buffer, 0);
+        DecodeProtobuf(receive, buffer, offset);
+        g_sink += command.command_type() + receive.message_id();
+    });
+    std::cout << "  encoded size: " << bytes << " bytes" << std::endl;
+
+    Report("fixed    command + receive", iterations, [&](size_t i) {
+        FixedCodec::encodeCommand(buffer.data(), CommandMessage_CommandType_MSG_RECV);
+        FixedCodec::encode(buffer.data() + FixedCodec::COMMAND_SIZE, FixedCodec::ReceiveMessage { static_cast<int64_t> (1000000000LL + i),
+            static_cast<uint32_t> (i & 0xffff), static_cast<uint32_t> (i), PROTO_CCH, -80 });
+        FixedCodec::ReceiveMessage decoded;
+        const int32_t decodedCommand = FixedCodec::decodeCommand(buffer.data());
+        FixedCodec::decode(buffer.data() + FixedCodec::COMMAND_SIZE, decoded);
+        g_sink += decodedCommand + decoded.message_id;
+    });
+    std::cout << "  encoded size: " << FixedCodec::COMMAND_SIZE + FixedCodec::RECEIVE_MESSAGE_SIZE << " bytes" << std::endl;
+
+    Report("protobuf command + send", iterations, [&](size_t i) {
+        command.set_command_type(CommandMessage_CommandType_MSG_SEND);
+        send.set_time(1000000000LL + i);
+        send.set_node_id(i & 0xffff);
+        send.set_channel_id(PROTO_CCH);
+        send.set_message_id(i);
+        send.set_length(300);
+        send.mutable_topo_address()->set_ip_address(0xffffffff);
+        send.mutable_topo_address()->set_ttl(1);
+        size_t offset = EncodeProtobuf(command, buffer, 0);
+        bytes = offset + EncodeProtobuf(send, buffer, offset);
+        offset = DecodeProtobuf(command, buffer, 0);
+        DecodeProtobuf(send, buffer, offset);
+        g_sink += command.command_type() + send.message_id();
+    });
+    std::cout << "  encoded size: " << bytes << " bytes" << std::endl;
+
+    Report("fixed    command + send", iterations, [&](size_t i) {
+        FixedCodec::encodeCommand(buffer.data(), CommandMessage_CommandType_MSG_SEND);
+        FixedCodec::encode(buffer.data() + FixedCodec::COMMAND_SIZE, FixedCodec::SendMessage { static_cast<int64_t> (1000000000LL + i),
+            static_cast<uint32_t> (i & 0xffff), PROTO_CCH, static_cast<uint32_t> (i), 300, 0xffffffff, 1 });
+        FixedCodec::SendMessage decoded;
+        const int32_t decodedCommand = FixedCodec::decodeCommand(buffer.data());
+        FixedCodec::decode(buffer.data() + FixedCodec::COMMAND_SIZE, decoded);
+        g_sink += decodedCommand + decoded.message_id;
+    });
+    std::cout << "  encoded size: " << FixedCodec::COMMAND_SIZE + FixedCodec::SEND_MESSAGE_SIZE << " bytes" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,448 @@
+/*
+ * Copyright (c) 2020 Fraunhofer FOKUS and others. All rights reserved.
+ *
+ * Contact: mosaic@fokus.fraunhofer.de
+ *
+ * This class is developed for the MOSAIC-NS-3 coupling.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+
+
+/**
+ * Runs the same workload through the in-process C API and through the socket coupling
+ * on loopback TCP: nodes are added and switched on, then every step moves all nodes,
+ * lets every node send one message and advances the time. The TCP mode plays a minimal
+ * ambassador with the legacy protocol against a MosaicNs3Server in a second thread.
+ * The server delays every send by a random jitter, the in-process mode adds the same.
+ * Prints the wall clock time of the stepping loop and the number of receptions.
+ *
+ * The simulator is a process wide singleton, hence one mode per run.
+ *
+ * usage: federate-api-benchmark inprocess|tcp [nodes] [steps] [port]
+ */
+
+#include "mosaic-federate-c.h"
+#include "mosaic-ns3-server.h"
+#include "ClientServerChannelMessages.pb.h"
+
+#include "ns3/global-value.h"
+#include "ns3/string.h"
+
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/io/zero_copy_stream_impl_lite.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace ClientServerChannelSpace;
+
+namespace {
+
+    const uint64_t STEP = 100000000;
+    const uint32_t BROADCAST = 0xFFFFFFFF;
+
+    struct Workload {
+        uint32_t nodes = 100;
+        uint32_t steps = 100;
+
+        uint64_t EndTime() const {
+            return (steps + 2) * STEP;
+        }
+
+        double X(uint32_t node, uint32_t step) const {
+            return (node % 20) * 50.0 + step * 1.5;
+        }
+
+        double Y(uint32_t node) const {
+            return (node / 20) * 50.0;
+        }
+    };
+
+    /**
+     * @brief the sending jitter MosaicNs3Server adds to every MSG_SEND, so both modes
+     * simulate the same transmissions
+     */
+    uint64_t SendJitter() {
+        return rand() % 100000000;
+    }
+
+    struct Result {
+        double seconds = 0.0;
+        uint64_t receptions = 0;
+        uint64_t nextEvents = 0;
+    };
+
+    Result RunInProcess(const Workload &workload) {
+        Result result;
+        mosaic_federate *federate = mosaic_federate_create(MOSAIC_COMM_DSRC, 0);
+        if (federate == nullptr || mosaic_federate_start(federate, workload.EndTime()) != 0) {
+            std::cerr << "Could not start the federate" << std::endl;
+            std::exit(1);
+        }
+        mosaic_federate_set_receive_callback(federate, [](void *user, uint64_t, uint32_t, int32_t) {
+            static_cast<Result*> (user)->receptions++;
+        }, &result);
+        mosaic_federate_set_next_event_callback(federate, [](void *user, uint64_t) {
+            static_cast<Result*> (user)->nextEvents++;
+        }, &result);
+
+        for (uint32_t node = 0; node < workload.nodes; node++) {
+            mosaic_federate_add_node(federate, STEP, node, workload.X(node, 0), workload.Y(node), 0);
+            mosaic_federate_configure_radio(federate, STEP, node, 1, 20, node);
+        }
+        mosaic_federate_advance_time(federate, STEP);
+
+        const auto start = std::chrono::steady_clock::now();
+        uint32_t msgID = workload.nodes;
+        for (uint32_t step = 1; step <= workload.steps; step++) {
+            const uint64_t time = (step + 1) * STEP;
+            for (uint32_t node = 0; node < workload.nodes; node++) {
+                mosaic_federate_move_node(federate, time, node, workload.X(node, step), workload.Y(node));
+            }
+            for (uint32_t node = 0; node < workload.nodes; node++) {
+                mosaic_federate_send(federate, time + SendJitter(), node, msgID++, 200, BROADCAST);
+            }
+            mosaic_federate_advance_time(federate, time);
+        }
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        mosaic_federate_destroy(federate);
+        return result;
+    }
+
+    /**
+     * @brief buffered reader of varint prefixed protobuf frames
+     */
+    class FrameReader {
+    public:
+        explicit FrameReader(int sock) : m_sock(sock) {
+        }
+
+        bool Read(google::protobuf::Message &message) {
+            uint32_t size = 0;
+            for (int shift = 0; shift < 35; shift += 7) {
+                if (!Fill(1)) {
+                    return false;
+                }
+                const uint8_t byte = m_buffer[m_begin++];
+                size |= static_cast<uint32_t> (byte & 0x7F) << shift;
+                if (!(byte & 0x80)) {
+                    break;
+                }
+            }
+            if (!Fill(size)) {
+                return false;
+            }
+            const bool parsed = message.ParseFromArray(m_buffer.data() + m_begin, size);
+            m_begin += size;
+            return parsed;
+        }
+
+    private:
+        bool Fill(size_t count) {
+            if (m_end - m_begin >= count) {
+                return true;
+            }
+            m_buffer.erase(m_buffer.begin(), m_buffer.begin() + m_begin);
+            m_end -= m_begin;
+            m_begin = 0;
+            m_buffer.resize(std::max<size_t>(m_buffer.size(), std::max<size_t>(count, 65536)));
+            while (m_end < count) {
+                const ssize_t received = recv(m_sock, m_buffer.data() + m_end, m_buffer.size() - m_end, 0);
+                if (received <= 0) {
+                    return false;
+                }
+                m_end += received;
+            }
+            return true;
+        }
+
+        int m_sock;
+        std::vector<char> m_buffer;
+        size_t m_begin = 0;
+        size_t m_end = 0;
+    };
+
+    void WriteFrames(int sock, const google::protobuf::Message &command, const google::protobuf::Message *body) {
+        std::string frames;
+        {
+            google::protobuf::io::StringOutputStream stringOut(&frames);
+            google::protobuf::io::CodedOutputStream codedOut(&stringOut);
+            codedOut.WriteVarint32(command.ByteSizeLong());
+            command.SerializeToCodedStream(&codedOut);
+            if (body != nullptr) {
+                codedOut.WriteVarint32(body->ByteSizeLong());
+                body->SerializeToCodedStream(&codedOut);
+            }
+        }
+        if (send(sock, frames.data(), frames.size(), 0) != static_cast<ssize_t> (frames.size())) {
+            std::cerr << "Could not send to the federate" << std::endl;
+            std::exit(1);
+        }
+    }
+
+    int Connect(uint16_t port, int attempts) {
+        sockaddr_in address;
+        std::memset(&address, 0, sizeof (address));
+        address.sin_family = AF_INET;
+        address.sin_port = htons(port);
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        for (int i = 0; i < attempts; i++) {
+            const int sock = socket(AF_INET, SOCK_STREAM, 0);
+            if (connect(sock, reinterpret_cast<sockaddr*> (&address), sizeof (address)) == 0) {
+                int flag = 1;
+                setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof (flag));
+                return sock;
+            }
+            close(sock);
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+        std::cerr << "Could not connect to port " << port << std::endl;
+        std::exit(1);
+    }
+
+    /**
+     * @brief the ambassador side of the coupling, events are consumed by a separate thread
+     * as in MOSAIC, so the federate never blocks on a full socket buffer
+     */
+    class Ambassador {
+    public:
+        explicit Ambassador(uint16_t port, Result &result) : m_result(result) {
+            m_eventSock = Connect(port, 100);
+            FrameReader eventReader(m_eventSock);
+            CommandMessage command;
+            PortExchange portExchange;
+            if (!eventReader.Read(command) || command.command_type() != CommandMessage_CommandType_INIT || !eventReader.Read(portExchange)) {
+                std::cerr << "Unexpected start of the coupling" << std::endl;
+                std::exit(1);
+            }
+            m_commandSock = Connect(portExchange.port_number(), 1);
+            m_commandReader.reset(new FrameReader(m_commandSock));
+            m_eventThread = std::thread(&Ambassador::ReadEvents, this, std::move(eventReader));
+        }
+
+        ~Ambassador() {
+            shutdown(m_eventSock, SHUT_RDWR);
+            m_eventThread.join();
+            close(m_eventSock);
+            close(m_commandSock);
+        }
+
+        void Init(uint64_t endTime) {
+            InitMessage init;
+            init.set_start_time(0);
+            init.set_end_time(endTime);
+            Command(CommandMessage_CommandType_INIT, &init, true);
+        }
+
+        void UpdateNodes(UpdateNode_UpdateType type, uint64_t time, const std::vector<std::pair<double, double>> &positions) {
+            UpdateNode update;
+            update.set_update_type(type);
+            update.set_time(time);
+            for (uint32_t node = 0; node < positions.size(); node++) {
+                UpdateNode_NodeData *data = update.add_properties();
+                data->set_id(node);
+                data->set_x(positions[node].first);
+                data->set_y(positions[node].second);
+            }
+            Command(CommandMessage_CommandType_UPDATE_NODE, &update, true);
+        }
+
+        void ConfigureRadio(uint64_t time, uint32_t node, uint32_t msgID) {
+            ConfigureRadioMessage config;
+            config.set_time(time);
+            config.set_message_id(msgID);
+            config.set_external_id(node);
+            config.set_radio_number(ConfigureRadioMessage_RadioNumber_SINGLE_RADIO);
+            ConfigureRadioMessage_RadioConfiguration *radio = config.mutable_primary_radio_configuration();
+            radio->set_receiving_messages(true);
+            radio->set_ip_address(0);
+            radio->set_subnet_address(0);
+            radio->set_transmission_power(20);
+            radio->set_radio_mode(ConfigureRadioMessage_RadioConfiguration_RadioMode_SINGLE_CHANNEL);
+            radio->set_primary_radio_channel(PROTO_CCH);
+            Command(CommandMessage_CommandType_CONF_RADIO, &config, true);
+        }
+
+        void Send(uint64_t time, uint32_t node, uint32_t msgID) {
+            SendMessageMessage message;
+            message.set_time(time);
+            message.set_node_id(node);
+            message.set_channel_id(PROTO_CCH);
+            message.set_message_id(msgID);
+            message.set_length(200);
+            message.mutable_topo_address()->set_ip_address(BROADCAST);
+            message.mutable_topo_address()->set_ttl(1);
+            Command(CommandMessage_CommandType_MSG_SEND, &message, true);
+        }
+
+        void AdvanceTime(uint64_t time) {
+            TimeMessage message;
+            message.set_time(time);
+            std::unique_lock<std::mutex> lock(m_mutex);
+            const uint64_t ends = m_ends;
+            lock.unlock();
+            Command(CommandMessage_CommandType_ADVANCE_TIME, &message, false);
+            lock.lock();
+            m_endReceived.wait(lock, [this, ends] { return m_ends > ends; });
+        }
+
+        void ShutDown() {
+            Command(CommandMessage_CommandType_SHUT_DOWN, nullptr, false);
+        }
+
+    private:
+        void Command(CommandMessage_CommandType type, const google::protobuf::Message *body, bool acked) {
+            CommandMessage command;
+            command.set_command_type(type);
+            WriteFrames(m_commandSock, command, body);
+            if (acked) {
+                CommandMessage reply;
+                if (!m_commandReader->Read(reply) || reply.command_type() != CommandMessage_CommandType_SUCCESS) {
+                    std::cerr << "Command " << type << " was not acknowledged" << std::endl;
+                    std::exit(1);
+                }
+            }
+        }
+
+        void ReadEvents(FrameReader reader) {
+            CommandMessage command;
+            TimeMessage time;
+            ReceiveMessage receive;
+            while (reader.Read(command)) {
+                if (command.command_type() == CommandMessage_CommandType_MSG_RECV) {
+                    if (!reader.Read(receive)) {
+                        break;
+                    }
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    m_result.receptions++;
+                } else {
+                    if (!reader.Read(time)) {
+                        break;
+                    }
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    if (command.command_type() == CommandMessage_CommandType_END) {
+                        m_ends++;
+                        m_endReceived.notify_all();
+                    } else {
+                        m_result.nextEvents++;
+                    }
+                }
+            }
+        }
+
+        Result &m_result;
+        int m_eventSock;
+        int m_commandSock;
+        std::unique_ptr<FrameReader> m_commandReader;
+        std::thread m_eventThread;
+        std::mutex m_mutex;
+        std::condition_variable m_endReceived;
+        uint64_t m_ends = 0;
+    };
+
+    Result RunTcp(const Workload &workload, uint16_t port) {
+        ns3::GlobalValue::Bind("SchedulerType", ns3::StringValue("ns3::ListScheduler"));
+        ns3::GlobalValue::Bind("SimulatorImplementationType", ns3::StringValue("ns3::MosaicSimulatorImpl"));
+        std::thread federate([port] {
+            ns3::FederateConfig config;
+            config.commType = DSRC;
+            ns3::MosaicNs3Server server(port, 0, config);
+            server.processCommandsUntilSimStep();
+        });
+
+        Result result;
+        {
+            Ambassador ambassador(port, result);
+            ambassador.Init(workload.EndTime());
+
+            std::vector<std::pair<double, double>> positions(workload.nodes);
+            for (uint32_t node = 0; node < workload.nodes; node++) {
+                positions[node] = std::make_pair(workload.X(node, 0), workload.Y(node));
+            }
+            ambassador.UpdateNodes(UpdateNode_UpdateType_ADD_VEHICLE, STEP, positions);
+            for (uint32_t node = 0; node < workload.nodes; node++) {
+                ambassador.ConfigureRadio(STEP, node, node);
+            }
+            ambassador.AdvanceTime(STEP);
+
+            const auto start = std::chrono::steady_clock::now();
+            uint32_t msgID = workload.nodes;
+            for (uint32_t step = 1; step <= workload.steps; step++) {
+                const uint64_t time = (step + 1) * STEP;
+                for (uint32_t node = 0; node < workload.nodes; node++) {
+                    positions[node].first = workload.X(node, step);
+                }
+                ambassador.UpdateNodes(UpdateNode_UpdateType_MOVE_NODE, time, positions);
+                for (uint32_t node = 0; node < workload.nodes; node++) {
+                    ambassador.Send(time, node, msgID++);
+                }
+                ambassador.AdvanceTime(time);
+            }
+            result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            ambassador.ShutDown();
+        }
+        federate.join();
+        return result;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        std::cerr << "usage: federate-api-benchmark inprocess|tcp [nodes] [steps] [port]" << std::endl;
+        return 1;
+    }
+    const std::string mode = argv[1];
+    Workload workload;
+    if (argc > 2) {
+        workload.nodes = std::strtoul(argv[2], nullptr, 10);
+    }
+    if (argc > 3) {
+        workload.steps = std::strtoul(argv[3], nullptr, 10);
+    }
+    const uint16_t port = argc > 4 ? std::atoi(argv[4]) : 5011;
+
+    Result result;
+    if (mode == "inprocess") {
+        result = RunInProcess(workload);
+    } else if (mode == "tcp") {
+        result = RunTcp(workload, port);
+    } else {
+        std::cerr << "Unknown mode " << mode << std::endl;
+        return 1;
+    }
+
+    std::cout << mode << ": " << workload.nodes << " nodes, " << workload.steps << " steps in " << result.seconds << " s, "
+            << result.seconds * 1e6 / workload.steps << " us per step, "
+            << result.receptions << " receptions, " << result.nextEvents << " next event notifications" << std::endl;
+    return 0;
+}
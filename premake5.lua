@@ -32,41 +32,8 @@ newoption {
 }
 
 
-workspace "ns3-federate"
-   configurations { "Debug", "Release" }
-
-project "ns3-federate"
-   kind "ConsoleApp"
-   language "C++"
-   targetdir "bin/%{cfg.buildcfg}"
-
-   files { "src/**.h"
-         , "src/**.cc" 
-         , PROTO_CC_PATH .. "/ClientServerChannel.h"
-         , PROTO_CC_PATH .. "/ClientServerChannel.cc"
-         , PROTO_CC_PATH .. "/ClientServerChannelMessages.pb.h"
-         , PROTO_CC_PATH .. "/ClientServerChannelMessages.pb.cc"
-         }
-
-   includedirs { "/usr/include"
-               , "/usr/include/libxml2"
-               , "src"
-               , PROTO_CC_PATH
-               }
-
-   libdirs { "/usr/lib" }
-
-   links { "pthread"
-         , "protobuf"
-         , "xml2"
-         }
-
-  configuration "generate-protobuf"
-    prebuildcommands { PROTOC .. " --cpp_out=" .. PROTO_CC_PATH
-                       .. " --proto_path=" .. PROTO_PATH
-                       .. " ClientServerChannelMessages.proto"
-                     }
-
+-- ns-3 modules linked by the federate library and everything using ns-3 directly
+function ns3links()
    filter "configurations:Debug"
       defines { "DEBUG" }
       symbols "On"
@@ -157,6 +124,76 @@ project "ns3-federate"
            , "ns3-dev-wimax-optimized"
            }
 
+   filter {}
+end
+
+
+workspace "ns3-federate"
+   configurations { "Debug", "Release" }
+
+-- the federate without the socket coupling entry point, embeddable through mosaic-federate-c.h
+project "mosaic-federate"
+   kind "SharedLib"
+   language "C++"
+   targetdir "bin/%{cfg.buildcfg}"
+
+   files { "src/**.h"
+         , "src/**.cc" 
+         , PROTO_CC_PATH .. "/ClientServerChannel.h"
+         , PROTO_CC_PATH .. "/ClientServerChannel.cc"
+         , PROTO_CC_PATH .. "/ClientServerChannelMessages.pb.h"
+         , PROTO_CC_PATH .. "/ClientServerChannelMessages.pb.cc"
+         }
+
+   removefiles { "src/mosaic_starter.cc" }
+
+   includedirs { "/usr/include"
+               , "/usr/include/libxml2"
+               , "src"
+               , PROTO_CC_PATH
+               }
+
+   libdirs { "/usr/lib" }
+
+   links { "pthread"
+         , "protobuf"
+         , "xml2"
+         , "lz4"
+         }
+
+  configuration "generate-protobuf"
+    prebuildcommands { PROTOC .. " --cpp_out=" .. PROTO_CC_PATH
+                       .. " --proto_path=" .. PROTO_PATH
+                       .. " ClientServerChannelMessages.proto"
+                     }
+
+   ns3links()
+
+project "ns3-federate"
+   kind "ConsoleApp"
+   language "C++"
+   targetdir "bin/%{cfg.buildcfg}"
+
+   files { "src/mosaic_starter.cc" }
+
+   includedirs { "/usr/include"
+               , "/usr/include/libxml2"
+               , "src"
+               , PROTO_CC_PATH
+               }
+
+   libdirs { "/usr/lib" }
+
+   links { "mosaic-federate"
+         , "pthread"
+         , "protobuf"
+         , "xml2"
+         }
+
+   runpathdirs { "bin/%{cfg.buildcfg}", install_prefix .. "/lib" }
+
+   ns3links()
+
     configuration "Debug"
         libdirs { "bin/Debug" }
 
@@ -164,6 +201,69 @@ project "ns3-federate"
         libdirs { "bin/Release" }
 
     configuration "install"
-        postbuildcommands { "mkdir -p " .. install_prefix .. "/bin"
+        postbuildcommands { "mkdir -p " .. install_prefix .. "/bin " .. install_prefix .. "/lib"
                           , "cp bin/%{cfg.buildcfg}/ns3-federate " .. install_prefix .. "/bin"
+                          , "cp bin/%{cfg.buildcfg}/libmosaic-federate.so " .. install_prefix .. "/lib"
                           }
+
+project "federate-api-benchmark"
+   kind "ConsoleApp"
+   language "C++"
+   targetdir "bin/%{cfg.buildcfg}"
+
+   files { "benchmark/federate-api-benchmark.cc" }
+
+   includedirs { "/usr/include"
+               , "src"
+               , PROTO_CC_PATH
+               }
+
+   links { "mosaic-federate"
+         , "pthread"
+         , "protobuf"
+         }
+
+   runpathdirs { "bin/%{cfg.buildcfg}" }
+
+   ns3links()
+
+project "codec-benchmark"
+   kind "ConsoleApp"
+   language "C++"
+   targetdir "bin/%{cfg.buildcfg}"
+
+   files { "benchmark/codec-benchmark.cc"
+         , "src/ClientServerChannelFixedCodec.h"
+         , PROTO_CC_PATH .. "/ClientServerChannelMessages.pb.h"
+         , PROTO_CC_PATH .. "/ClientServerChannelMessages.pb.cc"
+         }
+
+   includedirs { "/usr/include"
+               , "src"
+               , PROTO_CC_PATH
+               }
+
+   links { "pthread"
+         , "protobuf"
+         }
+
+   filter "configurations:Release"
+      defines { "NDEBUG" }
+      optimize "On"
+
+project "mosaic-logger-test"
+   kind "ConsoleApp"
+   language "C++"
+   targetdir "bin/%{cfg.buildcfg}"
+
+   files { "test/mosaic-logger-test.cc"
+         , "src/mosaic-logger.h"
+         , "src/mosaic-logger.cc"
+         }
+
+   includedirs { "/usr/include"
+               , "src"
+               }
+
+   links { "pthread"
+         }
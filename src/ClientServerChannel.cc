@@ -21,6 +21,7 @@
  */
 
 #include "ClientServerChannel.h"
+#include "ClientServerChannelFixedCodec.h"
 
 #include <arpa/inet.h>
 #include <google/protobuf/message.h>
@@ -34,14 +35,27 @@
 #include <netdb.h>
 #include <errno.h>
 #include <iomanip>
+#include <sstream>
 #include <poll.h>
-bool isLoggingEnabled = false;
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <limits>
+#include <lz4.h>
 #ifdef USE_OMNET_CLOG_H
 #include <omnetpp/clog.h>
 #define LOG_DEBUG EV_DEBUG
+#define LOG_DEBUG_ENABLED true
 #else
-// #define LOG_DEBUG std::cout 
-#define LOG_DEBUG if (!isLoggingEnabled) {} else std::cout
+#include "mosaic-logger.h"
+//statements go to the asynchronous logger, debug builds only
+#if MOSAIC_LOG_COMPILED_LEVEL >= MOSAIC_LOG_LEVEL_DEBUG
+#define LOG_DEBUG_ENABLED ns3::MosaicLogger::IsEnabled(MOSAIC_LOG_LEVEL_DEBUG)
+#define LOG_DEBUG if (!LOG_DEBUG_ENABLED) {} else ns3::MosaicLogStream(MOSAIC_LOG_LEVEL_DEBUG).Get()
+#else
+#define LOG_DEBUG_ENABLED false
+#define LOG_DEBUG if (true) {} else std::cout
+#endif
 #endif
 
 namespace std {
@@ -57,8 +71,12 @@ namespace std {
       case ClientServerChannelSpace::CMD::CMD_MSG_RECV: out << "CMD message receive"; break;
       case ClientServerChannelSpace::CMD::CMD_MSG_SEND: out << "CMD message send"; break;
       case ClientServerChannelSpace::CMD::CMD_CONF_RADIO: out << "CMD conf radio"; break;
+      case ClientServerChannelSpace::CMD::CMD_CONF_SIDELINK: out << "CMD conf sidelink"; break;
+      case ClientServerChannelSpace::CMD::CMD_MSG_SEND_BATCH: out << "CMD message send batch"; break;
       case ClientServerChannelSpace::CMD::CMD_END: out << "CMD end"; break;
       case ClientServerChannelSpace::CMD::CMD_SUCCESS: out << "CMD success"; break;
+      case ClientServerChannelSpace::CMD::CMD_ACK: out << "CMD ack"; break;
+      case ClientServerChannelSpace::CMD::CMD_ERROR: out << "CMD error"; break;
     }
     return out;
   }
@@ -122,6 +140,12 @@ std::string uint32_to_ip ( const unsigned int ip ) {
 ClientServerChannel::ClientServerChannel() {
   servsock = INVALID_SOCKET;
   sock = INVALID_SOCKET;
+  pipelined = false;
+  envelope = false;
+  fixed_codec = false;
+  compression = false;
+  compression_threshold = 1024;
+  stream = STREAM_AMBASSADOR_FEDERATE;
 }
 
 /**
@@ -190,13 +214,53 @@ void ClientServerChannel::connect(void) {
   setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, (const char*)&x, sizeof(x));
 }
 
+/**
+ * Accepts the connection to this channel or switches both channels to the multiplexed connection (blocking)
+ *
+ * @param established the channel already connected to the ambassador, which sent the port of this channel
+ */
+bool ClientServerChannel::connectOrMultiplex(ClientServerChannel &established) {
+  struct pollfd socks[2];
+  socks[0].fd = servsock;
+  socks[0].events = POLLIN;
+  socks[1].fd = established.sock;
+  socks[1].events = POLLIN;
+  int poll_res;
+  do {
+    socks[0].revents = 0;
+    socks[1].revents = 0;
+    poll_res = poll ( socks, 2, -1 );
+  } while ( poll_res < 0 && errno == EINTR );
+  if ( poll_res < 0 || socks[0].revents & POLLIN || !( socks[1].revents & POLLIN ) ) {
+    connect();
+    return false;
+  }
+
+  //the ambassador did not connect but talks on the established connection
+  established.multiplexer = std::make_shared < CSC_multiplexer > ( established.sock );
+  established.stream = STREAM_FEDERATE_AMBASSADOR;
+  multiplexer = established.multiplexer;
+  stream = STREAM_AMBASSADOR_FEDERATE;
+  sock = established.sock;
+  close ( servsock );
+  servsock = INVALID_SOCKET;
+  return true;
+}
+
+CSC_multiplexer::~CSC_multiplexer() {
+  if (sock >= 0) {
+    close(sock);
+  }
+}
+
 /**
  * Closes existing network connections.
  *
  */
 ClientServerChannel::~ClientServerChannel() {
 
-  if (sock >= 0) {
+  //a multiplexed socket is closed with the last channel using it
+  if (sock >= 0 && !multiplexer) {
     close(sock);
     sock = -1;
   }
@@ -214,14 +278,18 @@ void debug_byte_array ( const char* buffer, const size_t buffer_size ) {
 #ifdef USE_OMNET_CLOG_H
   using namespace omnetpp;
 #endif
+  if ( !LOG_DEBUG_ENABLED ) {
+    return;
+  }
   LOG_DEBUG << std::dec << "DEBUG: debug_byte_array buffer_size: " << buffer_size << std::endl;
-  for ( size_t i=0; i < buffer_size; i++ ) {
-    const char c = buffer[i];
-    LOG_DEBUG << std::dec << static_cast<int>(c);
-        LOG_DEBUG << (((i + 1) % 16 == 0) ? '\n' : ' ');
+  //one statement per line of 16 bytes
+  for ( size_t line=0; line < buffer_size; line += 16 ) {
+    std::ostringstream bytes;
+    for ( size_t i=line; i < std::min ( line + 16, buffer_size ); i++ ) {
+      bytes << std::dec << static_cast<int>(buffer[i]) << ' ';
+    }
+    LOG_DEBUG << bytes.str() << std::endl;
   }
-  LOG_DEBUG << std::endl;
-
 }
 
 /**
@@ -236,18 +304,34 @@ CMD  ClientServerChannel::readCommand() {
   using namespace omnetpp;
 #endif
   LOG_DEBUG << "readCommand" << std::endl;
+  if ( fixed_codec ) {
+    char command_buffer[FixedCodec::COMMAND_SIZE];
+    if ( !readFixed ( command_buffer, FixedCodec::COMMAND_SIZE ) ) {
+      std::cerr << "ERROR: reading of fixed command failed!" << std::endl;
+      return CMD_UNDEF;
+    }
+    const int32_t command = FixedCodec::decodeCommand ( command_buffer );
+    if ( !CommandMessage_CommandType_IsValid ( command ) ) {
+      std::cerr << "ERROR: unknown fixed command " << command << std::endl;
+      return CMD_UNDEF;
+    }
+    const CMD cmd = protoCMDToCMD ( static_cast < CommandMessage_CommandType > ( command ) );
+    LOG_DEBUG << "DEBUG: read command: " << cmd << std::endl;
+    return cmd;
+  }
   //Read the mandatory prefixed size
   const std::shared_ptr < uint32_t > message_size = readVarintPrefix ( sock );
-    if ( !message_size || *message_size < 0 ) {
+  if ( !message_size ) {
     std::cerr << "ERROR: reading of mandatory message size failed!" << std::endl;
     return CMD_UNDEF;
   }
   LOG_DEBUG << "DEBUG: read command announced message size: " << *message_size << std::endl;
-  //Allocate a fitting buffer and read message from stream
-  char message_buffer[*message_size];
-  size_t res = recv ( sock, message_buffer, *message_size, MSG_WAITALL );
+  //Allocate a fitting buffer and read message from stream, envelopes may carry large bodies
+  receive_buffer.resize ( *message_size );
+  char *message_buffer = receive_buffer.data();
+  ssize_t res = receive ( message_buffer, *message_size, MSG_WAITALL );
   LOG_DEBUG << "DEBUG: readCommand recv result: " << res << std::endl;
-  if ( *message_size > 0 && res != *message_size ) {
+  if ( *message_size > 0 && res != static_cast < ssize_t > ( *message_size ) ) {
     std::cerr << "ERROR: expected " << *message_size << " bytes, but red " << res << " bytes. poll ... " << std::endl;
     struct pollfd socks[1];
     socks[0].fd = sock;
@@ -263,13 +347,13 @@ CMD  ClientServerChannel::readCommand() {
       sleep(1);
       LOG_DEBUG << "poll ..." << std::endl;
     } while ( poll_res < 1 );
-    res = recv ( sock, message_buffer, *message_size, MSG_WAITALL );
+    res = receive ( message_buffer, *message_size, MSG_WAITALL );
     if ( retries != 3 && res < 1 ) {
       std::cerr << "ERROR: socket is ready, but cannot receive any bytes (" << res << "). Message sent?" << std::endl;
       return CMD_UNDEF;
     }
   }
-  if ( res != *message_size ) {
+  if ( res != static_cast < ssize_t > ( *message_size ) ) {
     std::cerr << "ERROR: reading of message body failed! Socket not ready." << std::endl;
     return CMD_UNDEF;
   }
@@ -282,14 +366,27 @@ CMD  ClientServerChannel::readCommand() {
 //  LOG_DEBUG << std::endl;
   if ( *message_size > 0 ) {
     debug_byte_array ( message_buffer, *message_size );
+    const char *payload = message_buffer;
+    size_t payload_size = *message_size;
+    if ( !unpackFrame ( payload, payload_size ) ) {
+      return CMD_UNDEF;
+    }
     //Create the streams that can parse the received data into the protobuf class
-    google::protobuf::io::ArrayInputStream arrayIn ( message_buffer, *message_size );
+    google::protobuf::io::ArrayInputStream arrayIn ( payload, payload_size );
     google::protobuf::io::CodedInputStream codedIn ( &arrayIn );
 
-    CommandMessage commandMessage;
-    commandMessage.ParseFromCodedStream(&codedIn);  //parse message
-    //pick the needed data from the protobuf message class and return it
-    const CMD cmd = protoCMDToCMD(commandMessage.command_type());
+    CMD cmd;
+    if ( envelope ) {
+      //the body stays in the envelope until the matching read method picks it up
+      received_envelope.Clear();
+      received_envelope.ParseFromCodedStream(&codedIn);
+      cmd = protoCMDToCMD(received_envelope.command_type());
+    } else {
+      CommandMessage commandMessage;
+      commandMessage.ParseFromCodedStream(&codedIn);  //parse message
+      //pick the needed data from the protobuf message class and return it
+      cmd = protoCMDToCMD(commandMessage.command_type());
+    }
     LOG_DEBUG << "DEBUG: read command: " << cmd << std::endl;
     return cmd;
   }
@@ -311,7 +408,7 @@ int ClientServerChannel::readInit ( CSC_init_return &return_value ) {
   if ( !message_size ) { return -1; }
   LOG_DEBUG << "DEBUG: read init announced message size: " << *message_size << std::endl;
   char message_buffer[*message_size];
-  const size_t count = recv ( sock, message_buffer, *message_size, MSG_WAITALL );
+  const size_t count = receive ( message_buffer, *message_size, MSG_WAITALL );
   LOG_DEBUG << "DEBUG: read init received message size: " << count << std::endl;
 
   google::protobuf::io::ArrayInputStream arrayIn ( message_buffer, *message_size );
@@ -322,9 +419,12 @@ int ClientServerChannel::readInit ( CSC_init_return &return_value ) {
 
   return_value.start_time = init_message.start_time();
   return_value.end_time = init_message.end_time();
+  return_value.has_features = init_message.has_features();
+  return_value.features = init_message.features();
 
   LOG_DEBUG << "DEBUG: read init start time: " << return_value.start_time << std::endl;
   LOG_DEBUG << "DEBUG: read init end time: " << return_value.end_time << std::endl;
+  LOG_DEBUG << "DEBUG: read init features: " << return_value.features << std::endl;
 
   return 0;
 }
@@ -340,27 +440,8 @@ int ClientServerChannel::readUpdateNode ( CSC_update_node_return &return_value )
   using namespace omnetpp;
 #endif
   LOG_DEBUG << "readUpdateNode" << std::endl;
-  const std::shared_ptr < uint32_t > message_size = readVarintPrefix ( sock );
-  if ( !message_size ) { return -1; }
-  LOG_DEBUG << "DEBUG: read update note announced message size: " << *message_size << std::endl;
-  if ( *message_size < 0 ) {
-    return 0;
-  }
-
-  char message_buffer[*message_size];
-  const size_t count = recv ( sock, message_buffer, *message_size, MSG_WAITALL );
-  LOG_DEBUG << "DEBUG: read update node received message size: " << count << std::endl;
-
-  if ( *message_size != count ) {
-    std::cerr << "ERROR: expected " << *message_size << " bytes, but red " << count << " bytes!" << std::endl;
-    return -1;
-  }
-
-  google::protobuf::io::ArrayInputStream arrayIn ( message_buffer, *message_size );
-  google::protobuf::io::CodedInputStream codedIn ( &arrayIn );
-
   UpdateNode update_message;
-  update_message.ParseFromCodedStream ( &codedIn );  //Parse message
+  if ( readBody ( update_message, Envelope::kUpdateNodeFieldNumber ) != 0 ) { return -1; }
 
   switch ( update_message.update_type() ) { //Convert the types from protobuf enum to our update message types
     case UpdateNode_UpdateType_ADD_RSU: return_value.type = UPDATE_ADD_RSU; break;
@@ -405,19 +486,16 @@ int64_t ClientServerChannel::readTimeMessage() {
   using namespace omnetpp;
 #endif
   LOG_DEBUG << "readTimeMessage" << std::endl;
-  const std::shared_ptr < uint32_t > message_size = readVarintPrefix(sock);
-  if ( !message_size ) { return -1; }
-  LOG_DEBUG << "DEBUG: read time announced message size: " << *message_size << std::endl;
-
-  char message_buffer[*message_size];
-  const size_t count = recv ( sock, message_buffer, *message_size, MSG_WAITALL );
-  LOG_DEBUG << "DEBUG: read time received message size: " << count << std::endl;
-
-  google::protobuf::io::ArrayInputStream arrayIn ( message_buffer, *message_size );
-  google::protobuf::io::CodedInputStream codedIn ( &arrayIn );
-
+  if ( fixed_codec ) {
+    char message_buffer[FixedCodec::TIME_MESSAGE_SIZE];
+    if ( !readFixed ( message_buffer, FixedCodec::TIME_MESSAGE_SIZE ) ) { return -1; }
+    FixedCodec::TimeMessage time_message;
+    FixedCodec::decode ( message_buffer, time_message );
+    LOG_DEBUG << "DEBUG: read time message: " << time_message.time << std::endl;
+    return time_message.time;
+  }
   TimeMessage time_message;
-  time_message.ParseFromCodedStream ( &codedIn );
+  if ( readBody ( time_message, Envelope::kTimeFieldNumber ) != 0 ) { return -1; }
 
   int64_t time = time_message.time();
   LOG_DEBUG << "DEBUG: read time message: " << time << std::endl;
@@ -435,19 +513,8 @@ int ClientServerChannel::readConfigurationMessage(CSC_config_message &return_val
   using namespace omnetpp;
 #endif
   LOG_DEBUG << "readConfigurationMessage" << std::endl;
-  const std::shared_ptr < uint32_t > message_size = readVarintPrefix ( sock );
-  if ( !message_size ) { return -1; }
-  LOG_DEBUG << "DEBUG: read config announced message size: " << *message_size << std::endl;
-
-  char message_buffer[*message_size];
-  const size_t count = recv ( sock, message_buffer, *message_size, MSG_WAITALL );
-  LOG_DEBUG << "DEBUG: read config received message size: " << count << std::endl;
-
-  google::protobuf::io::ArrayInputStream arrayIn ( message_buffer, *message_size );
-  google::protobuf::io::CodedInputStream codedIn ( &arrayIn );
-
   ConfigureRadioMessage conf_message;
-  conf_message.ParseFromCodedStream ( &codedIn );
+  if ( readBody ( conf_message, Envelope::kConfigureRadioFieldNumber ) != 0 ) { return -1; }
 
   return_value.time = conf_message.time();
   return_value.msg_id = conf_message.message_id();
@@ -537,7 +604,59 @@ int ClientServerChannel::readConfigurationMessage(CSC_config_message &return_val
         << return_value.secondary_radio.secondary_channel << std::endl;
     }
   }
-  writeCommand(CMD_SUCCESS);
+  if ( !pipelined ) {
+    writeCommand(CMD_SUCCESS);
+  }
+
+  return 0;
+}
+
+/**
+ * Reads a sidelink configuration message from the command channel and returns it
+ *
+ * Other than the remaining readers it writes no SUCCESS, the caller answers with SUCCESS or ERROR
+ * once it validated the configuration.
+ *
+ * @param return_value the struct to fill the data in
+ * @return 0 if successful
+ */
+int ClientServerChannel::readSidelinkConfigurationMessage(CSC_sidelink_config_message &return_value) {
+#ifdef USE_OMNET_CLOG_H
+  using namespace omnetpp;
+#endif
+  LOG_DEBUG << "readSidelinkConfigurationMessage" << std::endl;
+  ConfigureSidelinkMessage conf_message;
+  if ( readBody ( conf_message, Envelope::kConfigureSidelinkFieldNumber ) != 0 ) { return -1; }
+
+  return_value.time = conf_message.time();
+  return_value.preset = conf_message.preset();
+  return_value.has_carrier_freq = conf_message.has_carrier_freq();
+  return_value.carrier_freq = conf_message.carrier_freq();
+  return_value.has_sl_bandwidth = conf_message.has_sl_bandwidth();
+  return_value.sl_bandwidth = conf_message.sl_bandwidth();
+  return_value.has_message_id = conf_message.has_message_id();
+  return_value.message_id = conf_message.message_id();
+  LOG_DEBUG << "DEBUG: read sidelink config message time: " << return_value.time << std::endl;
+  LOG_DEBUG << "DEBUG: read sidelink config message preset: " << return_value.preset << std::endl;
+
+  return_value.pools.clear();
+  for ( int i = 0; i < conf_message.pools_size(); i++ ) {
+    const ConfigureSidelinkMessage_Pool &pool = conf_message.pools(i);
+    CSC_sidelink_pool returned_pool;
+    returned_pool.tx = pool.direction() != ConfigureSidelinkMessage_Pool_Direction_RX;
+    returned_pool.rx = pool.direction() != ConfigureSidelinkMessage_Pool_Direction_TX;
+    returned_pool.sl_subframe = pool.sl_subframe();
+    returned_pool.adjacency_pscch_pssch = pool.adjacency_pscch_pssch();
+    returned_pool.size_subchannel = pool.size_subchannel();
+    returned_pool.num_subchannel = pool.num_subchannel();
+    returned_pool.start_rb_subchannel = pool.start_rb_subchannel();
+    returned_pool.start_rb_pscch_pool = pool.start_rb_pscch_pool();
+    returned_pool.data_tx_p0 = pool.data_tx_p0();
+    returned_pool.data_tx_alpha = pool.data_tx_alpha();
+    LOG_DEBUG << "DEBUG: read sidelink config message pool " << i << " subchannels: "
+      << returned_pool.num_subchannel << "x" << returned_pool.size_subchannel << std::endl;
+    return_value.pools.push_back(returned_pool);
+  }
 
   return 0;
 }
@@ -553,20 +672,78 @@ int ClientServerChannel::readSendMessage ( CSC_send_message &return_value ) {
   using namespace omnetpp;
 #endif
   LOG_DEBUG << "readSendMessage" << std::endl;
-  std::shared_ptr < uint32_t > message_size = readVarintPrefix ( sock );
-  if ( !message_size ) { return -1; }
-  LOG_DEBUG << "DEBUG: read send announced message size: " << *message_size << std::endl;
+  if ( fixed_codec ) {
+    char message_buffer[FixedCodec::SEND_MESSAGE_SIZE];
+    if ( !readFixed ( message_buffer, FixedCodec::SEND_MESSAGE_SIZE ) ) { return -1; }
+    FixedCodec::SendMessage send_message;
+    FixedCodec::decode ( message_buffer, send_message );
+    if ( !RadioChannel_IsValid ( send_message.channel_id ) ) {
+      std::cerr << "ERROR: unknown radio channel " << send_message.channel_id << std::endl;
+      return -1;
+    }
+    return_value.time = send_message.time;
+    return_value.node_id = send_message.node_id;
+    return_value.channel_id = protoChannelToChannel ( static_cast < RadioChannel > ( send_message.channel_id ) );
+    return_value.message_id = send_message.message_id;
+    return_value.length = send_message.length;
+    return_value.topo_address.ip_address = send_message.ip_address;
+    return_value.topo_address.ttl = send_message.ttl;
+    LOG_DEBUG << "DEBUG: read fixed send message node id: " << return_value.node_id
+      << " message id: " << return_value.message_id << std::endl;
+    if ( !pipelined ) {
+      writeCommand(CMD_SUCCESS);
+    }
+    return 0;
+  }
+  SendMessageMessage send_message;
+  if ( readBody ( send_message, Envelope::kSendMessageFieldNumber ) != 0 ) { return -1; }
 
-  char message_buffer[*message_size];
-  const size_t count = recv ( sock, message_buffer, *message_size, MSG_WAITALL );
-  LOG_DEBUG << "DEBUG: read send received message size: " << count << std::endl;
+  protoToSendMessage(send_message, return_value);
+  if ( !pipelined ) {
+    writeCommand(CMD_SUCCESS);
+  }
 
-  google::protobuf::io::ArrayInputStream arrayIn ( message_buffer, *message_size );
-  google::protobuf::io::CodedInputStream codedIn ( &arrayIn );
+  return 0;
+}
 
-  SendMessageMessage send_message;
-  send_message.ParseFromCodedStream(&codedIn);
+/**
+ * Reads a batch of sendMessage bodies from the channel, acked once for the whole batch
+ *
+ * @param return_value the vector the messages are appended to
+ * @return 0 if successful
+ */
+int ClientServerChannel::readSendMessageBatch ( std::vector<CSC_send_message> &return_value ) {
+#ifdef USE_OMNET_CLOG_H
+  using namespace omnetpp;
+#endif
+  LOG_DEBUG << "readSendMessageBatch" << std::endl;
+  SendMessageBatch batch_message;
+  if ( readBody ( batch_message, Envelope::kSendMessageBatchFieldNumber ) != 0 ) { return -1; }
+
+  return_value.reserve ( return_value.size() + batch_message.messages_size() );
+  for ( const SendMessageMessage &send_message : batch_message.messages() ) {
+    CSC_send_message returned_message;
+    protoToSendMessage ( send_message, returned_message );
+    return_value.push_back ( returned_message );
+  }
+  LOG_DEBUG << "DEBUG: read send batch messages: " << batch_message.messages_size() << std::endl;
+  if ( !pipelined ) {
+    writeCommand(CMD_SUCCESS);
+  }
+
+  return 0;
+}
 
+/**
+ * Copies the fields of a protobuf send message into the struct
+ *
+ * @param send_message the parsed message
+ * @param return_value the struct to fill the data in
+ */
+void ClientServerChannel::protoToSendMessage ( const SendMessageMessage &send_message, CSC_send_message &return_value ) {
+#ifdef USE_OMNET_CLOG_H
+  using namespace omnetpp;
+#endif
   return_value.time = send_message.time();
   return_value.node_id = send_message.node_id();
 
@@ -597,9 +774,6 @@ int ClientServerChannel::readSendMessage ( CSC_send_message &return_value ) {
     LOG_DEBUG << "DEBUG: read send message topo address ip: " << return_value.topo_address.ip_address << std::endl;
     LOG_DEBUG << "DEBUG: read send message topo address ttl: " << return_value.topo_address.ttl << std::endl;
   }
-  writeCommand(CMD_SUCCESS);
-
-  return 0;
 }
 
 //#####################################################
@@ -617,22 +791,22 @@ void ClientServerChannel::writeCommand(CMD cmd) {
   using namespace omnetpp;
 #endif
   LOG_DEBUG << "writeCommand" << std::endl;
-  CommandMessage commandMessage;
   LOG_DEBUG << "DEBUG: write command: " << cmd << std::endl;
+  if ( fixed_codec ) {
+    char command_buffer[FixedCodec::COMMAND_SIZE];
+    FixedCodec::encodeCommand ( command_buffer, cmdToProtoCMD(cmd) );
+    writeFixed ( command_buffer, FixedCodec::COMMAND_SIZE );
+    return;
+  }
+  if ( envelope ) {
+    Envelope envelope_message;
+    envelope_message.set_command_type(cmdToProtoCMD(cmd));
+    writeFrame(envelope_message);
+    return;
+  }
+  CommandMessage commandMessage;
   commandMessage.set_command_type(cmdToProtoCMD(cmd));
-  int varintsize = google::protobuf::io::CodedOutputStream::VarintSize32(commandMessage.ByteSize());
-  LOG_DEBUG << "DEBUG: write command varint size: " << varintsize << std::endl;
-  int buffer_size = varintsize+commandMessage.ByteSize();
-  LOG_DEBUG << "DEBUG: write command buffer size: " << buffer_size << std::endl;
-  char message_buffer[buffer_size];
-
-  google::protobuf::io::ArrayOutputStream arrayOut ( message_buffer, buffer_size );
-  google::protobuf::io::CodedOutputStream codedOut ( &arrayOut );
-
-  codedOut.WriteVarint32(commandMessage.ByteSize());
-  commandMessage.SerializeToCodedStream(&codedOut);
-  const size_t count = send ( sock, message_buffer, buffer_size, 0 );
-  LOG_DEBUG << "DEBUG: write command send bytes: " << count << std::endl;
+  writeFrame(commandMessage);
 }
 
 /**
@@ -649,52 +823,152 @@ void ClientServerChannel::writeReceiveMessage(uint64_t time, int node_id, int me
   using namespace omnetpp;
 #endif
   LOG_DEBUG << "writeReceiveMessage" << std::endl;
+  if ( fixed_codec ) {
+    char message_buffer[FixedCodec::RECEIVE_MESSAGE_SIZE];
+    FixedCodec::encode ( message_buffer, FixedCodec::ReceiveMessage { static_cast < int64_t > ( time ),
+      static_cast < uint32_t > ( node_id ), static_cast < uint32_t > ( message_id ), channelToProtoChannel ( channel ), rssi } );
+    writeFixed ( message_buffer, FixedCodec::RECEIVE_MESSAGE_SIZE );
+    return;
+  }
   ReceiveMessage receive_message;
-  receive_message.set_time(time);
-  receive_message.set_node_id(node_id);
-  receive_message.set_message_id(message_id);
-  receive_message.set_channel_id(channelToProtoChannel(channel));
-  receive_message.set_rssi(rssi);
-  int varintsize = google::protobuf::io::CodedOutputStream::VarintSize32(receive_message.ByteSize());
-  LOG_DEBUG << "DEBUG: write receive message varint size: " << varintsize << std::endl;
-  int buffer_size = varintsize+receive_message.ByteSize();
-  LOG_DEBUG << "DEBUG: write receive message buffer size: " << buffer_size << std::endl;
-  char message_buffer[buffer_size];
-
-  google::protobuf::io::ArrayOutputStream arrayOut ( message_buffer, buffer_size );
-  google::protobuf::io::CodedOutputStream codedOut ( &arrayOut );
-
-  codedOut.WriteVarint32 ( receive_message.ByteSize() );
-  receive_message.SerializeToCodedStream ( &codedOut );
-  const size_t count = send ( sock, message_buffer, buffer_size, 0 );
-  LOG_DEBUG << "DEBUG: write receive message send bytes: " << count << std::endl;
+  fillReceiveMessage(receive_message, time, node_id, message_id, channel, rssi);
+  writeFrame(receive_message);
+}
+
+/**
+ * Writes CMD_MSG_RECV and a receiveMessage body onto the channel, as one frame in envelope mode.
+ *
+ * @see writeReceiveMessage
+ */
+void ClientServerChannel::writeReceiveCommand(uint64_t time, int node_id, int message_id, RADIO_CHANNEL channel, int rssi) {
+  if ( fixed_codec ) {
+    //command and body in one send
+    char message_buffer[FixedCodec::COMMAND_SIZE + FixedCodec::RECEIVE_MESSAGE_SIZE];
+    FixedCodec::encodeCommand ( message_buffer, cmdToProtoCMD(CMD_MSG_RECV) );
+    FixedCodec::encode ( message_buffer + FixedCodec::COMMAND_SIZE, FixedCodec::ReceiveMessage { static_cast < int64_t > ( time ),
+      static_cast < uint32_t > ( node_id ), static_cast < uint32_t > ( message_id ), channelToProtoChannel ( channel ), rssi } );
+    writeFixed ( message_buffer, sizeof(message_buffer) );
+    return;
+  }
+  if ( !envelope ) {
+    writeCommand(CMD_MSG_RECV);
+    writeReceiveMessage(time, node_id, message_id, channel, rssi);
+    return;
+  }
+  Envelope envelope_message;
+  envelope_message.set_command_type(cmdToProtoCMD(CMD_MSG_RECV));
+  fillReceiveMessage(*envelope_message.mutable_receive_message(), time, node_id, message_id, channel, rssi);
+  writeFrame(envelope_message);
 }
 
 /**
  * Writes a time onto the channel
  *
  * @param time the time to write
+ * @param lookahead time after time without any output of the federate, not sent if negative
  */
-void ClientServerChannel::writeTimeMessage(int64_t time) {
+void ClientServerChannel::writeTimeMessage(int64_t time, int64_t lookahead) {
 #ifdef USE_OMNET_CLOG_H
   using namespace omnetpp;
 #endif
-  LOG_DEBUG << "DEBUG: write time message: " << time << std::endl;
+  LOG_DEBUG << "DEBUG: write time message: " << time << " lookahead: " << lookahead << std::endl;
+  if ( fixed_codec ) {
+    char message_buffer[FixedCodec::TIME_MESSAGE_SIZE];
+    FixedCodec::encode ( message_buffer, FixedCodec::TimeMessage { time, lookahead >= 0 ? lookahead : -1 } );
+    writeFixed ( message_buffer, FixedCodec::TIME_MESSAGE_SIZE );
+    return;
+  }
   TimeMessage time_message;
-  time_message.set_time ( time );
-  int varintsize = google::protobuf::io::CodedOutputStream::VarintSize32 ( time_message.ByteSize() );
-  LOG_DEBUG << "DEBUG: write time message varint size: " << varintsize << std::endl;
-  int buffer_size = varintsize+time_message.ByteSize();
-  LOG_DEBUG << "DEBUG: write time message buffer size: " << buffer_size << std::endl;
-  char message_buffer[buffer_size];
+  fillTimeMessage(time_message, time, lookahead);
+  writeFrame(time_message);
+}
+
+/**
+ * Writes a command and a time onto the channel, as one frame in envelope mode.
+ *
+ * @param cmd the command, e.g. CMD_END or CMD_NEXT_EVENT
+ * @see writeTimeMessage
+ */
+void ClientServerChannel::writeTimeCommand(CMD cmd, int64_t time, int64_t lookahead) {
+  if ( fixed_codec ) {
+    //command and body in one send
+    char message_buffer[FixedCodec::COMMAND_SIZE + FixedCodec::TIME_MESSAGE_SIZE];
+    FixedCodec::encodeCommand ( message_buffer, cmdToProtoCMD(cmd) );
+    FixedCodec::encode ( message_buffer + FixedCodec::COMMAND_SIZE, FixedCodec::TimeMessage { time, lookahead >= 0 ? lookahead : -1 } );
+    writeFixed ( message_buffer, sizeof(message_buffer) );
+    return;
+  }
+  if ( !envelope ) {
+    writeCommand(cmd);
+    writeTimeMessage(time, lookahead);
+    return;
+  }
+  Envelope envelope_message;
+  envelope_message.set_command_type(cmdToProtoCMD(cmd));
+  fillTimeMessage(*envelope_message.mutable_time(), time, lookahead);
+  writeFrame(envelope_message);
+}
+
+/**
+ * Sends the accepted protocol features to the ambassador.
+ *
+ * @param features bitmask of FEATURE
+ */
+void ClientServerChannel::writeFeatures(uint32_t features) {
+#ifdef USE_OMNET_CLOG_H
+  using namespace omnetpp;
+#endif
+  LOG_DEBUG << "writeFeatures features: " << features << std::endl;
+  FeatureMessage feature_message;
+  feature_message.set_features ( features );
+  writeFrame(feature_message);
+}
+
+/**
+ * Sends the cumulative ack of the pipelined commands, preceded by CMD_ACK.
+ *
+ * @param accepted number of commands read since the last ack
+ * @param failed_message_ids message ids of the commands which failed since the last ack
+ */
+void ClientServerChannel::writePipelineAck(uint32_t accepted, const std::vector<uint32_t> &failed_message_ids) {
+#ifdef USE_OMNET_CLOG_H
+  using namespace omnetpp;
+#endif
+  LOG_DEBUG << "writePipelineAck accepted: " << accepted << " failed: " << failed_message_ids.size() << std::endl;
+  Envelope envelope_message;
+  PipelineAck &ack_message = *envelope_message.mutable_pipeline_ack();
+  ack_message.set_accepted ( accepted );
+  for ( uint32_t message_id : failed_message_ids ) {
+    ack_message.add_failed_message_ids ( message_id );
+  }
+  if ( envelope ) {
+    envelope_message.set_command_type(cmdToProtoCMD(CMD_ACK));
+    writeFrame(envelope_message);
+  } else {
+    writeCommand(CMD_ACK);
+    writeFrame(ack_message);
+  }
+}
+
+void ClientServerChannel::setPipelined(bool pipelined) {
+  this->pipelined = pipelined;
+}
+
+void ClientServerChannel::setEnvelope(bool envelope) {
+  this->envelope = envelope;
+}
+
+void ClientServerChannel::setFixedCodec(bool fixed_codec) {
+  this->fixed_codec = fixed_codec;
+}
 
-  google::protobuf::io::ArrayOutputStream arrayOut ( message_buffer, buffer_size );
-  google::protobuf::io::CodedOutputStream codedOut ( &arrayOut);
+void ClientServerChannel::setCompression(bool compression, uint32_t threshold) {
+  this->compression = compression;
+  this->compression_threshold = threshold;
+}
 
-  codedOut.WriteVarint32 ( time_message.ByteSize() );
-  time_message.SerializeToCodedStream ( &codedOut );
-  const size_t count = send ( sock, message_buffer, buffer_size, 0 );
-  LOG_DEBUG << "DEBUG: write time message send bytes: " << count << std::endl;
+const CSC_compression_stats &ClientServerChannel::getCompressionStats() const {
+  return compression_stats;
 }
 
 /**
@@ -702,33 +976,301 @@ void ClientServerChannel::writeTimeMessage(int64_t time) {
  *
  * @param port port
  */
-void ClientServerChannel::writePort(uint32_t port) {
+void ClientServerChannel::writePort(uint32_t port, bool multiplex) {
 #ifdef USE_OMNET_CLOG_H
   using namespace omnetpp;
 #endif
   LOG_DEBUG << "writePort port: " << port << std::endl;
   PortExchange port_exchange;
   port_exchange.set_port_number ( port );
+  if ( multiplex ) {
+    port_exchange.set_multiplex ( true );
+  }
   LOG_DEBUG << "DEBUG: write port exchange: " << port_exchange.port_number() << std::endl;
-  int varintsize = google::protobuf::io::CodedOutputStream::VarintSize32(port_exchange.ByteSize());
-  LOG_DEBUG << "DEBUG: write port message varint size: " << varintsize << std::endl;
-  int buffer_size = varintsize+port_exchange.ByteSize();
-  LOG_DEBUG << "DEBUG: write port message buffer size: " << buffer_size << std::endl;
-  char message_buffer[buffer_size];
-
-  google::protobuf::io::ArrayOutputStream arrayOut ( message_buffer, buffer_size );
-  google::protobuf::io::CodedOutputStream codedOut ( &arrayOut);
-
-  codedOut.WriteVarint32(port_exchange.ByteSize());
-  port_exchange.SerializeToCodedStream(&codedOut);
-  const size_t count = send ( sock, message_buffer, buffer_size, 0 );
-  LOG_DEBUG << "DEBUG: write port message send bytes: " << count << std::endl;
+  writeFrame(port_exchange);
 }
 
 //#####################################################
 //  Private helpers
 //#####################################################
 
+/**
+ * @brief Reads the body of the command returned by the last readCommand
+ *
+ * In envelope mode the body was already received with the command and is moved out of the envelope,
+ * otherwise it is read as its own varint prefixed frame.
+ *
+ * @param message the message to fill
+ * @param envelope_field number of the body field in Envelope, which has to match the message type
+ * @return 0 if successful
+ */
+int ClientServerChannel::readBody ( google::protobuf::Message &message, int envelope_field ) {
+#ifdef USE_OMNET_CLOG_H
+  using namespace omnetpp;
+#endif
+  if ( envelope ) {
+    const google::protobuf::FieldDescriptor *field = Envelope::descriptor()->FindFieldByNumber ( envelope_field );
+    const google::protobuf::Reflection *reflection = received_envelope.GetReflection();
+    if ( field == nullptr || !reflection->HasField ( received_envelope, field ) ) {
+      std::cerr << "ERROR: envelope of command " << received_envelope.command_type() << " has no body " << envelope_field << std::endl;
+      return -1;
+    }
+    message.GetReflection()->Swap ( &message, reflection->MutableMessage ( &received_envelope, field ) );
+    return 0;
+  }
+
+  const std::shared_ptr < uint32_t > message_size = readVarintPrefix ( sock );
+  if ( !message_size ) { return -1; }
+  LOG_DEBUG << "DEBUG: read " << message.GetTypeName() << " announced message size: " << *message_size << std::endl;
+
+  // bodies like send message batches may be large, keep them off the stack
+  receive_buffer.resize ( *message_size );
+  if ( !readFixed ( receive_buffer.data(), *message_size ) ) { return -1; }
+  LOG_DEBUG << "DEBUG: read " << message.GetTypeName() << " received message size: " << *message_size << std::endl;
+
+  const char *payload = receive_buffer.data();
+  size_t payload_size = *message_size;
+  if ( !unpackFrame ( payload, payload_size ) ) { return -1; }
+  google::protobuf::io::ArrayInputStream arrayIn ( payload, payload_size );
+  google::protobuf::io::CodedInputStream codedIn ( &arrayIn );
+  if ( !message.ParseFromCodedStream ( &codedIn ) ) { return -1; }
+  return 0;
+}
+
+/**
+ * @brief Receives from the socket, or from the stream of this channel if the connection is multiplexed
+ *
+ * Without MSG_WAITALL the call returns the bytes pending for the stream, reading one more frame if there are none.
+ */
+ssize_t ClientServerChannel::receive ( char *buffer, size_t size, int flags ) {
+  if ( !multiplexer ) {
+    return recv ( sock, buffer, size, flags );
+  }
+  std::string &pending = multiplexer->pending[stream];
+  size_t &offset = multiplexer->pending_offset[stream];
+  const size_t wanted = ( flags & MSG_WAITALL ) ? size : std::min < size_t > ( size, 1 );
+  while ( pending.size() - offset < wanted ) {
+    if ( !readMultiplexFrame() ) {
+      return -1;
+    }
+  }
+  const size_t count = std::min ( size, pending.size() - offset );
+  std::memcpy ( buffer, pending.data() + offset, count );
+  offset += count;
+  if ( offset == pending.size() ) {
+    pending.clear();
+    offset = 0;
+  }
+  return count;
+}
+
+/**
+ * @brief Reads one frame of the multiplexed connection and appends it to the bytes of its stream
+ */
+bool ClientServerChannel::readMultiplexFrame() {
+  char header[5];
+  if ( recv ( multiplexer->sock, header, sizeof(header), MSG_WAITALL ) != sizeof(header) ) {
+    std::cerr << "ERROR: reading of multiplex frame header failed!" << std::endl;
+    return false;
+  }
+  const unsigned int frame_stream = static_cast < unsigned char > ( header[0] );
+  const uint32_t frame_size = FixedCodec::load < uint32_t > ( header, 1 );
+  if ( frame_stream > STREAM_FEDERATE_AMBASSADOR ) {
+    std::cerr << "ERROR: unknown multiplex stream " << frame_stream << std::endl;
+    return false;
+  }
+  std::string &pending = multiplexer->pending[frame_stream];
+  const size_t old_size = pending.size();
+  pending.resize ( old_size + frame_size );
+  if ( frame_size > 0 && recv ( multiplexer->sock, &pending[old_size], frame_size, MSG_WAITALL ) != static_cast < ssize_t > ( frame_size ) ) {
+    std::cerr << "ERROR: reading of multiplex frame failed!" << std::endl;
+    pending.resize ( old_size );
+    return false;
+  }
+  return true;
+}
+
+/**
+ * @brief Sends on the socket, or as one frame of the stream of this channel if the connection is multiplexed
+ */
+ssize_t ClientServerChannel::transmit ( const char *buffer, size_t size ) {
+  if ( !multiplexer ) {
+    return send ( sock, buffer, size, 0 );
+  }
+  std::vector<char> &frame = multiplexer->frame_buffer;
+  frame.resize ( 5 + size );
+  frame[0] = static_cast < char > ( stream );
+  FixedCodec::store < uint32_t > ( frame.data(), 1, size );
+  std::memcpy ( frame.data() + 5, buffer, size );
+  //a frame sent only partially would desynchronize all streams, so send until it is complete
+  size_t sent = 0;
+  while ( sent < frame.size() ) {
+    const ssize_t count = send ( multiplexer->sock, frame.data() + sent, frame.size() - sent, 0 );
+    if ( count <= 0 ) {
+      return -1;
+    }
+    sent += count;
+  }
+  return size;
+}
+
+bool ClientServerChannel::readFixed ( char *buffer, size_t size ) {
+  const ssize_t count = receive ( buffer, size, MSG_WAITALL );
+  if ( count < 0 || static_cast < size_t > ( count ) != size ) {
+    std::cerr << "ERROR: expected " << size << " bytes, but red " << count << " bytes!" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+void ClientServerChannel::writeFixed ( const char *buffer, size_t size ) {
+#ifdef USE_OMNET_CLOG_H
+  using namespace omnetpp;
+#endif
+  const size_t count = transmit ( buffer, size );
+  LOG_DEBUG << "DEBUG: write fixed send bytes: " << count << std::endl;
+}
+
+/**
+ * @brief Writes a message prefixed with its size as varint
+ */
+void ClientServerChannel::writeFrame ( const google::protobuf::Message &message ) {
+#ifdef USE_OMNET_CLOG_H
+  using namespace omnetpp;
+#endif
+  const size_t message_size = message.ByteSizeLong();
+  //the size prefix is a varint32, the header byte of a compressed channel has to fit as well
+  if ( message_size > std::numeric_limits < uint32_t >::max() - 1 ) {
+    std::cerr << "ERROR: " << message.GetTypeName() << " of " << message_size << " bytes exceeds the frame limit" << std::endl;
+    return;
+  }
+  if ( compression && message_size >= compression_threshold && message_size <= LZ4_MAX_INPUT_SIZE ) {
+    writeCompressedFrame ( message, static_cast < int > ( message_size ) );
+    return;
+  }
+  //with compression every frame starts with the header byte, 0 for an uncompressed message
+  const uint32_t payload_size = ( compression ? 1 : 0 ) + static_cast < uint32_t > ( message_size );
+  const size_t buffer_size = google::protobuf::io::CodedOutputStream::VarintSize32 ( payload_size ) + payload_size;
+  send_buffer.resize ( buffer_size );
+
+  {
+    // newer protobuf versions buffer inside the coded stream until it is destroyed
+    google::protobuf::io::ArrayOutputStream arrayOut ( send_buffer.data(), buffer_size );
+    google::protobuf::io::CodedOutputStream codedOut ( &arrayOut );
+
+    codedOut.WriteVarint32 ( payload_size );
+    if ( compression ) {
+      codedOut.WriteRaw ( "\0", 1 );
+    }
+    message.SerializeWithCachedSizes ( &codedOut );
+  }
+  const size_t count = transmit ( send_buffer.data(), buffer_size );
+  LOG_DEBUG << "DEBUG: write " << message.GetTypeName() << " send bytes: " << count << std::endl;
+}
+
+/**
+ * @brief Writes a message as LZ4 block, falls back to the uncompressed frame if it does not shrink
+ *
+ * Frame: varint payload size, byte 1, varint message size, LZ4 block
+ */
+void ClientServerChannel::writeCompressedFrame ( const google::protobuf::Message &message, int message_size ) {
+#ifdef USE_OMNET_CLOG_H
+  using namespace omnetpp;
+#endif
+  const auto start = std::chrono::steady_clock::now();
+  std::vector<char> &raw_buffer = serialize_buffer;
+  raw_buffer.resize ( message_size );
+  message.SerializeWithCachedSizesToArray ( reinterpret_cast < uint8_t* > ( raw_buffer.data() ) );
+  compress_buffer.resize ( LZ4_compressBound ( message_size ) );
+  const int compressed_size = LZ4_compress_default ( raw_buffer.data(), compress_buffer.data(), message_size, compress_buffer.size() );
+  compression_stats.compress_seconds += std::chrono::duration < double > ( std::chrono::steady_clock::now() - start ).count();
+
+  const int size_varint = google::protobuf::io::CodedOutputStream::VarintSize32 ( message_size );
+  const bool compressed = compressed_size > 0 && 1 + size_varint + compressed_size < 1 + message_size;
+  const int payload_size = compressed ? 1 + size_varint + compressed_size : 1 + message_size;
+  const int buffer_size = google::protobuf::io::CodedOutputStream::VarintSize32 ( payload_size ) + payload_size;
+  send_buffer.resize ( buffer_size );
+  {
+    google::protobuf::io::ArrayOutputStream arrayOut ( send_buffer.data(), buffer_size );
+    google::protobuf::io::CodedOutputStream codedOut ( &arrayOut );
+
+    codedOut.WriteVarint32 ( payload_size );
+    if ( compressed ) {
+      codedOut.WriteRaw ( "\1", 1 );
+      codedOut.WriteVarint32 ( message_size );
+      codedOut.WriteRaw ( compress_buffer.data(), compressed_size );
+    } else {
+      codedOut.WriteRaw ( "\0", 1 );
+      codedOut.WriteRaw ( raw_buffer.data(), message_size );
+    }
+  }
+  if ( compressed ) {
+    compression_stats.frames_compressed++;
+    compression_stats.raw_bytes_compressed += message_size;
+    compression_stats.compressed_bytes_sent += payload_size;
+  }
+  const size_t count = transmit ( send_buffer.data(), buffer_size );
+  LOG_DEBUG << "DEBUG: write " << message.GetTypeName() << " compressed " << message_size << " to " << payload_size << " send bytes: " << count << std::endl;
+}
+
+/**
+ * @brief Removes the compression header of a received frame payload
+ *
+ * Compressed payloads are decompressed into decompress_buffer, data and size then point there.
+ *
+ * @return false if the frame is corrupt
+ */
+bool ClientServerChannel::unpackFrame ( const char *&data, size_t &size ) {
+  if ( !compression ) {
+    return true;
+  }
+  if ( size < 1 ) {
+    std::cerr << "ERROR: frame without compression header" << std::endl;
+    return false;
+  }
+  if ( data[0] == 0 ) {
+    data++;
+    size--;
+    return true;
+  }
+  const auto start = std::chrono::steady_clock::now();
+  google::protobuf::io::CodedInputStream sizeIn ( reinterpret_cast < const uint8_t* > ( data + 1 ), size - 1 );
+  uint32_t message_size = 0;
+  if ( data[0] != 1 || !sizeIn.ReadVarint32 ( &message_size ) ) {
+    std::cerr << "ERROR: unknown compression header" << std::endl;
+    return false;
+  }
+  const size_t header_size = 1 + sizeIn.CurrentPosition();
+  decompress_buffer.resize ( message_size );
+  const int result = LZ4_decompress_safe ( data + header_size, decompress_buffer.data(), size - header_size, message_size );
+  if ( result < 0 || static_cast < uint32_t > ( result ) != message_size ) {
+    std::cerr << "ERROR: decompression of frame failed: " << result << std::endl;
+    return false;
+  }
+  compression_stats.frames_decompressed++;
+  compression_stats.compressed_bytes_received += size;
+  compression_stats.raw_bytes_decompressed += message_size;
+  compression_stats.decompress_seconds += std::chrono::duration < double > ( std::chrono::steady_clock::now() - start ).count();
+  data = decompress_buffer.data();
+  size = message_size;
+  return true;
+}
+
+void ClientServerChannel::fillTimeMessage ( TimeMessage &time_message, int64_t time, int64_t lookahead ) {
+  time_message.set_time ( time );
+  if ( lookahead >= 0 ) {
+    time_message.set_lookahead ( lookahead );
+  }
+}
+
+void ClientServerChannel::fillReceiveMessage ( ReceiveMessage &receive_message, uint64_t time, int node_id, int message_id, RADIO_CHANNEL channel, int rssi ) {
+  receive_message.set_time ( time );
+  receive_message.set_node_id ( node_id );
+  receive_message.set_message_id ( message_id );
+  receive_message.set_channel_id ( channelToProtoChannel ( channel ) );
+  receive_message.set_rssi ( rssi );
+}
+
 /**
  * @brief Reads a variable length integer from the channel
  *
@@ -745,18 +1287,18 @@ std::shared_ptr < uint32_t > ClientServerChannel::readVarintPrefix(SOCKET sock)
   char current_byte;
 
   //first receive one byte from the channel
-  const size_t count = recv ( sock, &current_byte, 1, 0 );
+  const ssize_t count = receive ( &current_byte, 1, 0 );
 
   num_bytes++;
-  if(count<0) {   //If we could not read one byte, return error
+  if ( count <= 0 ) {   //If we could not read one byte or the peer closed the connection, return error
     return std::shared_ptr < uint32_t> ();
   }
   int return_value = ( current_byte & 0x7f );   //We get effectively 7 bits per byte
   while ( current_byte & 0x80 ) { //as long as the msb is set, there comes another byte
     current_byte = 0;
-    const size_t count = recv ( sock, &current_byte, 1, 0 );  //receive another byte
+    const ssize_t count = receive ( &current_byte, 1, 0 );  //receive another byte
     num_bytes++;
-    if ( count < 0 || num_bytes > 4) {          //If we have too many bytes or reading failed return error
+    if ( count <= 0 || num_bytes > 4) {          //If we have too many bytes or reading failed return error
       return std::shared_ptr < uint32_t>();
     }
     return_value |= ( current_byte & 0x7F ) << ( 7 * (num_bytes - 1 ) );    //Add the next 7 bits
@@ -781,8 +1323,12 @@ CommandMessage_CommandType ClientServerChannel::cmdToProtoCMD(CMD cmd) {
 
     case CMD_MSG_SEND: return CommandMessage_CommandType_MSG_SEND;
     case CMD_CONF_RADIO: return CommandMessage_CommandType_CONF_RADIO;
+    case CMD_CONF_SIDELINK: return CommandMessage_CommandType_CONF_SIDELINK;
+    case CMD_MSG_SEND_BATCH: return CommandMessage_CommandType_MSG_SEND_BATCH;
 
     case CMD_END: return CommandMessage_CommandType_END;
+    case CMD_ACK: return CommandMessage_CommandType_ACK;
+    case CMD_ERROR: return CommandMessage_CommandType_ERROR;
 
     default: return CommandMessage_CommandType_UNDEF;
   }
@@ -804,8 +1350,12 @@ CMD ClientServerChannel::protoCMDToCMD(CommandMessage_CommandType cmd) {
 
     case CommandMessage_CommandType_MSG_SEND: return CMD_MSG_SEND;
     case CommandMessage_CommandType_CONF_RADIO: return CMD_CONF_RADIO;
+    case CommandMessage_CommandType_CONF_SIDELINK: return CMD_CONF_SIDELINK;
+    case CommandMessage_CommandType_MSG_SEND_BATCH: return CMD_MSG_SEND_BATCH;
 
     case CommandMessage_CommandType_END: return  CMD_END;
+    case CommandMessage_CommandType_ACK: return CMD_ACK;
+    case CommandMessage_CommandType_ERROR: return CMD_ERROR;
 
     default: return CMD_UNDEF;
   }
@@ -27,6 +27,8 @@
 #include "ClientServerChannelMessages.pb.h"
 
 #include <memory> // shared_ptr
+#include <string>
+#include <vector>
 
 typedef int SOCKET;
 constexpr const int SOCKET_ERROR = -1;
@@ -39,7 +41,9 @@ namespace ClientServerChannelSpace {
 
 enum CommunicationType {
 	DSRC = 1,
-	LTE = 2
+	LTE = 2,
+	// no radio stack, receivers from range and PER curve, see MosaicAnalyticalChannel
+	ANALYTICAL = 3
 };
 
 
@@ -58,9 +62,39 @@ enum CMD {
 //--> Communication
     CMD_MSG_SEND = 30,
     CMD_CONF_RADIO = 31,
+    CMD_CONF_SIDELINK = 32,
+    CMD_MSG_SEND_BATCH = 33,
 //--> General
 	CMD_END = 40,
-	CMD_SUCCESS = 41
+	CMD_SUCCESS = 41,
+	CMD_ACK = 42,
+	CMD_ERROR = 43
+};
+
+enum FEATURE {
+	FEATURE_NONE = 0,
+	FEATURE_PIPELINED = 1,
+	FEATURE_ENVELOPE = 2,
+	FEATURE_FIXED_CODEC = 4,
+	FEATURE_COMPRESSION = 8,
+	FEATURE_MULTIPLEX = 16
+};
+
+/** Stream ids of a multiplexed connection */
+enum MULTIPLEX_STREAM {
+	STREAM_AMBASSADOR_FEDERATE = 0,
+	STREAM_FEDERATE_AMBASSADOR = 1
+};
+
+/** Connection shared by both channels in multiplexed mode, keeps the received bytes of each stream in order */
+struct CSC_multiplexer{
+	SOCKET sock;
+	std::string pending[2];
+	size_t pending_offset[2] = { 0, 0 };
+	std::vector<char> frame_buffer;
+
+	explicit CSC_multiplexer(SOCKET sock) : sock(sock) {}
+	~CSC_multiplexer();
 };
 
 enum RADIO_NUMBER {
@@ -95,6 +129,8 @@ enum RADIO_CHANNEL {
 struct CSC_init_return{
     int64_t start_time;
     int64_t end_time;
+    bool has_features;
+    uint32_t features;
 };
 
 struct CSC_node_data{
@@ -122,6 +158,31 @@ struct CSC_config_message{
     CSC_radio_config secondary_radio;
 };
 
+struct CSC_sidelink_pool{
+	bool tx;
+	bool rx;
+	uint32_t sl_subframe;
+	bool adjacency_pscch_pssch;
+	uint32_t size_subchannel;
+	uint32_t num_subchannel;
+	uint32_t start_rb_subchannel;
+	uint32_t start_rb_pscch_pool;
+	int32_t data_tx_p0;
+	double data_tx_alpha;
+};
+
+struct CSC_sidelink_config_message{
+	int64_t time;
+	std::string preset;
+	bool has_carrier_freq;
+	uint32_t carrier_freq;
+	bool has_sl_bandwidth;
+	uint32_t sl_bandwidth;
+	std::vector<CSC_sidelink_pool> pools;
+	bool has_message_id;
+	uint32_t message_id;
+};
+
 struct CSC_update_node_return{
 	UPDATE_NODE_TYPE type;
 	int64_t time;
@@ -142,6 +203,18 @@ struct CSC_send_message{
 	CSC_topo_address topo_address;
 };
 
+/** Counters of the frame compression, sizes without the varint prefix */
+struct CSC_compression_stats{
+	uint64_t frames_compressed = 0;
+	uint64_t raw_bytes_compressed = 0;
+	uint64_t compressed_bytes_sent = 0;
+	double compress_seconds = 0;
+	uint64_t frames_decompressed = 0;
+	uint64_t compressed_bytes_received = 0;
+	uint64_t raw_bytes_decompressed = 0;
+	double decompress_seconds = 0;
+};
+
 class ClientServerChannel {
 
 	public:
@@ -157,6 +230,14 @@ class ClientServerChannel {
 		/** Accepts connection to socket */
 		virtual void connect();
 
+		/**
+		 * Waits until the ambassador either connects to this channel or starts sending on the established
+		 * channel. In the latter case both channels share the established connection as two streams.
+		 *
+		 * @return true if the connection is multiplexed
+		 */
+		virtual bool connectOrMultiplex(ClientServerChannel &established);
+
 		/*################## READING ####################*/
 
 		/** reads a command via protobuf and returns it */
@@ -171,9 +252,15 @@ class ClientServerChannel {
 		/** Reads a configuration message from the channel and returns it */
 		virtual int readConfigurationMessage(CSC_config_message &return_value);
 
+		/** Reads a sidelink configuration message from the channel and returns it, the caller writes SUCCESS or ERROR */
+		virtual int readSidelinkConfigurationMessage(CSC_sidelink_config_message &return_value);
+
 		/** Reads a send message command and returns the corresponding message struct */
 		virtual int readSendMessage(CSC_send_message &return_value);
 
+		/** Reads a batch of send messages, appended to return_value */
+		virtual int readSendMessageBatch(std::vector<CSC_send_message> &return_value);
+
 		/** Reads TimeMessage from the channel and returns the contained time as a long */
 		virtual int64_t readTimeMessage();
 
@@ -182,11 +269,38 @@ class ClientServerChannel {
 		/** Byte protocol control method for writeCommand. */
 		virtual void writeCommand(CMD cmd);
 
+		/** Write the features the federate accepted to the output */
+		virtual void writeFeatures(uint32_t features);
+
+		/** Write the cumulative ack of the pipelined commands */
+		virtual void writePipelineAck(uint32_t accepted, const std::vector<uint32_t> &failed_message_ids);
+
+		/** In pipelined mode send and configuration messages are read without writing SUCCESS */
+		virtual void setPipelined(bool pipelined);
+
+		/** In envelope mode a command and its body are read and written as one frame */
+		virtual void setEnvelope(bool envelope);
+
+		/** With the fixed codec commands and the frequent bodies use the layout of ClientServerChannelFixedCodec.h */
+		virtual void setFixedCodec(bool fixed_codec);
+
+		/** With compression frames of at least threshold bytes are sent LZ4 compressed, received frames may be compressed */
+		virtual void setCompression(bool compression, uint32_t threshold = 1024);
+
+		/** Counters of the frame compression since the channel was created */
+		virtual const CSC_compression_stats &getCompressionStats() const;
+
+		/** Write a command followed by a time message, one frame in envelope mode */
+		virtual void writeTimeCommand(CMD cmd, int64_t time, int64_t lookahead = -1);
+
+		/** Write CMD_MSG_RECV followed by a receive message, one frame in envelope mode */
+		virtual void writeReceiveCommand(uint64_t time, int node_id, int message_id, RADIO_CHANNEL channel, int rssi);
+
 		/** Write a message containing a port number to the output */
-		virtual void writePort(uint32_t port);
+		virtual void writePort(uint32_t port, bool multiplex = false);
 
-		/** Request a time advance from the RTI */
-		virtual void writeTimeMessage(int64_t time);
+		/** Request a time advance from the RTI, a lookahead >= 0 promises no output before time + lookahead */
+		virtual void writeTimeMessage(int64_t time, int64_t lookahead = -1);
 
 		/** Signal and hand a received Message to the RTI */
 		virtual void writeReceiveMessage(uint64_t time, int node_id, int message_id, RADIO_CHANNEL channel, int rssi);
@@ -201,12 +315,77 @@ class ClientServerChannel {
 		/** Socket name **/
 		std::string channel_name;
 
+		/** Whether send and configuration messages are acked one by one */
+		bool pipelined;
+
+		/** Whether commands and bodies share one Envelope frame */
+		bool envelope;
+
+		/** Whether the fixed layout codec is used for the frequent messages */
+		bool fixed_codec;
+
+		/** Whether frames carry the compression header */
+		bool compression;
+
+		/** Minimum message size to try compression */
+		uint32_t compression_threshold;
+
+		CSC_compression_stats compression_stats;
+
+		/** Buffers reused for all frames, they only grow */
+		std::vector<char> receive_buffer;
+		std::vector<char> decompress_buffer;
+		std::vector<char> send_buffer;
+		std::vector<char> compress_buffer;
+		std::vector<char> serialize_buffer;
+
+		/** Envelope of the last command read in envelope mode, holds the body for the next read */
+		Envelope received_envelope;
+
 		/** Converts commands to protobuf-internal commands */
 		virtual CommandMessage_CommandType cmdToProtoCMD(CMD cmd);
 
 		/** Converts protobuf commands to CMD enum */
 		virtual CMD protoCMDToCMD(CommandMessage_CommandType cmd);
 
+		/** Copies a protobuf send message into the struct */
+		virtual void protoToSendMessage(const SendMessageMessage &send_message, CSC_send_message &return_value);
+
+		/** Multiplexed connection and the stream of this channel, null if the channel has its own socket */
+		std::shared_ptr < CSC_multiplexer > multiplexer;
+		MULTIPLEX_STREAM stream;
+
+		/** recv on the socket or on the stream of this channel */
+		virtual ssize_t receive(char *buffer, size_t size, int flags);
+
+		/** send on the socket or as frame of the stream of this channel */
+		virtual ssize_t transmit(const char *buffer, size_t size);
+
+		/** Reads the next frame of the multiplexed connection into the pending bytes of its stream */
+		virtual bool readMultiplexFrame();
+
+		/** Reads the body of the current command, from the envelope or from its own frame */
+		virtual int readBody(google::protobuf::Message &message, int envelope_field);
+
+		/** Receives exactly size bytes, false if the channel delivered less */
+		virtual bool readFixed(char *buffer, size_t size);
+
+		/** Sends size bytes in one call */
+		virtual void writeFixed(const char *buffer, size_t size);
+
+		/** Writes a varint length prefixed message */
+		virtual void writeFrame(const google::protobuf::Message &message);
+
+		/** Writes a varint length prefixed message as LZ4 block, if that is smaller */
+		virtual void writeCompressedFrame(const google::protobuf::Message &message, int message_size);
+
+		/** Strips the compression header of a received frame and decompresses it into decompress_buffer */
+		virtual bool unpackFrame(const char *&data, size_t &size);
+
+		/** Fills protobuf bodies */
+		virtual void fillTimeMessage(TimeMessage &time_message, int64_t time, int64_t lookahead);
+		virtual void fillReceiveMessage(ReceiveMessage &receive_message, uint64_t time, int node_id, int message_id, RADIO_CHANNEL channel, int rssi);
+
 		/** Reads a Varint from a socket and returns it */
 		virtual std::shared_ptr < uint32_t > readVarintPrefix(SOCKET sock);
 
@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) 2020 Fraunhofer FOKUS and others. All rights reserved.
+ *
+ * Contact: mosaic@fokus.fraunhofer.de
+ *
+ * This class is developed for the MOSAIC-NS-3 coupling.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+
+#ifndef __CLIENTSERVERCHANNELFIXEDCODEC_H__
+#define __CLIENTSERVERCHANNELFIXEDCODEC_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/**
+ * Fixed layout encoding of the most frequent messages, used instead of protobuf once
+ * FIXED_CODEC is negotiated at INIT. All fields are little-endian and at fixed offsets,
+ * there are no tags and no length prefixes. On little-endian hosts encoding and decoding
+ * are plain copies.
+ *
+ * Layouts (offset: field):
+ *   Command (4 bytes):          0: int32 CommandMessage.CommandType
+ *   TimeMessage (16 bytes):     0: int64 time, 8: int64 lookahead (-1 if none)
+ *   ReceiveMessage (24 bytes):  0: int64 time, 8: uint32 node_id, 12: uint32 message_id,
+ *                               16: int32 RadioChannel, 20: int32 rssi
+ *   SendMessage (32 bytes):     0: int64 time, 8: uint32 node_id, 12: int32 RadioChannel,
+ *                               16: uint32 message_id, 20: uint32 length, 24: uint32 ip_address, 28: uint32 ttl
+ *
+ * A command with one of these bodies is followed directly by the fixed body. All other
+ * bodies keep their varint prefixed protobuf frame.
+ */
+namespace ClientServerChannelSpace {
+
+namespace FixedCodec {
+
+constexpr const size_t COMMAND_SIZE = 4;
+constexpr const size_t TIME_MESSAGE_SIZE = 16;
+constexpr const size_t RECEIVE_MESSAGE_SIZE = 24;
+constexpr const size_t SEND_MESSAGE_SIZE = 32;
+
+struct TimeMessage {
+	int64_t time;
+	int64_t lookahead;
+};
+
+struct ReceiveMessage {
+	int64_t time;
+	uint32_t node_id;
+	uint32_t message_id;
+	int32_t channel_id;
+	int32_t rssi;
+};
+
+struct SendMessage {
+	int64_t time;
+	uint32_t node_id;
+	int32_t channel_id;
+	uint32_t message_id;
+	uint32_t length;
+	uint32_t ip_address;
+	uint32_t ttl;
+};
+
+/** Writes value little-endian to buffer + offset */
+template < typename T >
+inline void store ( char *buffer, size_t offset, T value ) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+	std::memcpy ( buffer + offset, &value, sizeof(T) );
+#else
+	uint64_t bits = static_cast < uint64_t > ( value );
+	for ( size_t i = 0; i < sizeof(T); i++ ) {
+		buffer[offset + i] = static_cast < char > ( ( bits >> ( 8 * i ) ) & 0xff );
+	}
+#endif
+}
+
+/** Reads a little-endian value from buffer + offset */
+template < typename T >
+inline T load ( const char *buffer, size_t offset ) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+	T value;
+	std::memcpy ( &value, buffer + offset, sizeof(T) );
+	return value;
+#else
+	uint64_t bits = 0;
+	for ( size_t i = 0; i < sizeof(T); i++ ) {
+		bits |= static_cast < uint64_t > ( static_cast < unsigned char > ( buffer[offset + i] ) ) << ( 8 * i );
+	}
+	return static_cast < T > ( bits );
+#endif
+}
+
+inline void encodeCommand ( char *buffer, int32_t command ) {
+	store < int32_t > ( buffer, 0, command );
+}
+
+inline int32_t decodeCommand ( const char *buffer ) {
+	return load < int32_t > ( buffer, 0 );
+}
+
+inline void encode ( char *buffer, const TimeMessage &message ) {
+	store ( buffer, 0, message.time );
+	store ( buffer, 8, message.lookahead );
+}
+
+inline void decode ( const char *buffer, TimeMessage &message ) {
+	message.time = load < int64_t > ( buffer, 0 );
+	message.lookahead = load < int64_t > ( buffer, 8 );
+}
+
+inline void encode ( char *buffer, const ReceiveMessage &message ) {
+	store ( buffer, 0, message.time );
+	store ( buffer, 8, message.node_id );
+	store ( buffer, 12, message.message_id );
+	store ( buffer, 16, message.channel_id );
+	store ( buffer, 20, message.rssi );
+}
+
+inline void decode ( const char *buffer, ReceiveMessage &message ) {
+	message.time = load < int64_t > ( buffer, 0 );
+	message.node_id = load < uint32_t > ( buffer, 8 );
+	message.message_id = load < uint32_t > ( buffer, 12 );
+	message.channel_id = load < int32_t > ( buffer, 16 );
+	message.rssi = load < int32_t > ( buffer, 20 );
+}
+
+inline void encode ( char *buffer, const SendMessage &message ) {
+	store ( buffer, 0, message.time );
+	store ( buffer, 8, message.node_id );
+	store ( buffer, 12, message.channel_id );
+	store ( buffer, 16, message.message_id );
+	store ( buffer, 20, message.length );
+	store ( buffer, 24, message.ip_address );
+	store ( buffer, 28, message.ttl );
+}
+
+inline void decode ( const char *buffer, SendMessage &message ) {
+	message.time = load < int64_t > ( buffer, 0 );
+	message.node_id = load < uint32_t > ( buffer, 8 );
+	message.channel_id = load < int32_t > ( buffer, 12 );
+	message.message_id = load < uint32_t > ( buffer, 16 );
+	message.length = load < uint32_t > ( buffer, 20 );
+	message.ip_address = load < uint32_t > ( buffer, 24 );
+	message.ttl = load < uint32_t > ( buffer, 28 );
+}
+
+} // namespace FixedCodec
+
+} // namespace ClientServerChannelSpace
+
+#endif // __CLIENTSERVERCHANNELFIXEDCODEC_H__
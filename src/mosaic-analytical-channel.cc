@@ -0,0 +1,225 @@
+/*
+ * Copyright (c) 2020 Fraunhofer FOKUS and others. All rights reserved.
+ *
+ * Contact: mosaic@fokus.fraunhofer.de
+ *
+ * This class is developed for the MOSAIC-NS-3 coupling.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+
+#include "mosaic-analytical-channel.h"
+
+#include "mosaic-logger.h"
+#include "ns3/double.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/string.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <sstream>
+
+NS_LOG_COMPONENT_DEFINE("MosaicAnalyticalChannel");
+
+namespace ns3 {
+
+    NS_OBJECT_ENSURE_REGISTERED(MosaicAnalyticalChannel);
+
+    TypeId MosaicAnalyticalChannel::GetTypeId(void) {
+        static TypeId tid = TypeId("ns3::MosaicAnalyticalChannel")
+                .SetParent<Object>()
+                .AddConstructor<MosaicAnalyticalChannel>()
+                .AddAttribute("Range", "Maximum distance in meters a transmission is delivered to, 0 delivers to all nodes",
+                DoubleValue(500.0),
+                MakeDoubleAccessor(&MosaicAnalyticalChannel::m_range),
+                MakeDoubleChecker<double>(0.0))
+                .AddAttribute("PerCurve", "Packet error rate over the distance as comma separated distance:per points, "
+                "linear between the points and constant beyond the first and the last point",
+                StringValue("0:0"),
+                MakeStringAccessor(&MosaicAnalyticalChannel::SetPerCurve, &MosaicAnalyticalChannel::GetPerCurve),
+                MakeStringChecker())
+                .AddAttribute("Latency", "Delay of every reception in addition to the serialization of the payload",
+                TimeValue(MilliSeconds(1)),
+                MakeTimeAccessor(&MosaicAnalyticalChannel::m_latency),
+                MakeTimeChecker())
+                .AddAttribute("DataRate", "Data rate for the serialization of the payload",
+                DataRateValue(DataRate("6Mbps")),
+                MakeDataRateAccessor(&MosaicAnalyticalChannel::m_dataRate),
+                MakeDataRateChecker())
+                .AddAttribute("CellSize", "Edge length in meters of a cell of the spatial index",
+                DoubleValue(250.0),
+                MakeDoubleAccessor(&MosaicAnalyticalChannel::SetCellSize, &MosaicAnalyticalChannel::GetCellSize),
+                MakeDoubleChecker<double>(1.0));
+        return tid;
+    }
+
+    MosaicAnalyticalChannel::MosaicAnalyticalChannel() : m_range(500.0), m_latency(MilliSeconds(1)), m_dataRate("6Mbps") {
+        m_perCurve.push_back(std::make_pair(0.0, 0.0));
+        m_random = CreateObject<UniformRandomVariable>();
+    }
+
+    void MosaicAnalyticalChannel::DoDispose(void) {
+        m_receiveCallback = ReceiveCallback();
+        m_random = nullptr;
+        m_deliveries = decltype(m_deliveries)();
+        Object::DoDispose();
+    }
+
+    void MosaicAnalyticalChannel::SetReceiveCallback(ReceiveCallback callback) {
+        m_receiveCallback = callback;
+    }
+
+    void MosaicAnalyticalChannel::UpdatePosition(uint32_t nodeId, const Vector &position) {
+        m_grid.Update(nodeId, position);
+    }
+
+    void MosaicAnalyticalChannel::Remove(uint32_t nodeId) {
+        m_grid.Remove(nodeId);
+        m_radioOff.erase(nodeId);
+    }
+
+    bool MosaicAnalyticalChannel::Contains(uint32_t nodeId) const {
+        return m_grid.Contains(nodeId);
+    }
+
+    void MosaicAnalyticalChannel::SetRadioEnabled(uint32_t nodeId, bool enabled) {
+        if (enabled) {
+            m_radioOff.erase(nodeId);
+        } else {
+            m_radioOff.insert(nodeId);
+        }
+    }
+
+    void MosaicAnalyticalChannel::Send(uint32_t nodeId, uint32_t msgID, uint32_t payLength) {
+        if (!m_grid.Contains(nodeId) || m_radioOff.count(nodeId) > 0) {
+            return;
+        }
+        const Vector sender = m_grid.GetPosition(nodeId);
+        m_grid.Query(sender, m_range, m_inRange);
+
+        std::vector<uint32_t> receivers;
+        receivers.reserve(m_inRange.size());
+        // the ids are sorted, so the random draws do not depend on the hash order of the grid
+        for (uint32_t receiver : m_inRange) {
+            if (receiver == nodeId || m_radioOff.count(receiver) > 0) {
+                continue;
+            }
+            const double per = GetPer(CalculateDistance(sender, m_grid.GetPosition(receiver)));
+            if (per > 0 && m_random->GetValue() < per) {
+                continue;
+            }
+            receivers.push_back(receiver);
+        }
+        MOSAIC_LOG_DEBUG("MosaicAnalyticalChannel::Send node {} message {}, {} in range, {} receivers", nodeId, msgID, m_inRange.size(), receivers.size());
+        if (receivers.empty()) {
+            return;
+        }
+        const Time delay = m_latency + m_dataRate.CalculateBytesTxTime(payLength);
+        Simulator::Schedule(delay, &MosaicAnalyticalChannel::Deliver, this, receivers, msgID);
+        DropPastDeliveries();
+        m_deliveries.push(Simulator::Now() + delay);
+    }
+
+    void MosaicAnalyticalChannel::Deliver(std::vector<uint32_t> receivers, uint32_t msgID) {
+        if (m_receiveCallback.IsNull()) {
+            return;
+        }
+        for (uint32_t receiver : receivers) {
+            // nodes removed or switched off while the message was in flight do not receive it
+            if (m_grid.Contains(receiver) && m_radioOff.count(receiver) == 0) {
+                m_receiveCallback(receiver, msgID);
+            }
+        }
+    }
+
+    Time MosaicAnalyticalChannel::GetLatency(void) const {
+        return m_latency;
+    }
+
+    Time MosaicAnalyticalChannel::GetNextDelivery(void) const {
+        DropPastDeliveries();
+        return m_deliveries.empty() ? Time::Max() : m_deliveries.top();
+    }
+
+    void MosaicAnalyticalChannel::DropPastDeliveries(void) const {
+        // a delivery due now may not have been executed yet, so only older ones are dropped
+        while (!m_deliveries.empty() && m_deliveries.top() < Simulator::Now()) {
+            m_deliveries.pop();
+        }
+    }
+
+    int64_t MosaicAnalyticalChannel::AssignStreams(int64_t stream) {
+        m_random->SetStream(stream);
+        return 1;
+    }
+
+    double MosaicAnalyticalChannel::GetPer(double distance) const {
+        if (distance <= m_perCurve.front().first) {
+            return m_perCurve.front().second;
+        }
+        if (distance >= m_perCurve.back().first) {
+            return m_perCurve.back().second;
+        }
+        auto upper = std::upper_bound(m_perCurve.begin(), m_perCurve.end(), distance,
+                [](double d, const std::pair<double, double> &point) {
+                    return d < point.first; });
+        auto lower = upper - 1;
+        const double fraction = (distance - lower->first) / (upper->first - lower->first);
+        return lower->second + fraction * (upper->second - lower->second);
+    }
+
+    void MosaicAnalyticalChannel::SetPerCurve(std::string curve) {
+        std::vector<std::pair<double, double>> points;
+        std::istringstream stream(curve);
+        std::string point;
+        while (std::getline(stream, point, ',')) {
+            const std::size_t separator = point.find(':');
+            if (separator == std::string::npos) {
+                NS_FATAL_ERROR("Invalid point [" << point << "] in PER curve [" << curve << "], expected distance:per");
+            }
+            const double distance = std::atof(point.substr(0, separator).c_str());
+            const double per = std::atof(point.substr(separator + 1).c_str());
+            if (per < 0 || per > 1) {
+                NS_FATAL_ERROR("PER " << per << " of PER curve [" << curve << "] is not within [0, 1]");
+            }
+            points.push_back(std::make_pair(distance, per));
+        }
+        if (points.empty()) {
+            NS_FATAL_ERROR("Empty PER curve");
+        }
+        std::stable_sort(points.begin(), points.end(),
+                [](const std::pair<double, double> &a, const std::pair<double, double> &b) {
+                    return a.first < b.first; });
+        m_perCurve = points;
+    }
+
+    std::string MosaicAnalyticalChannel::GetPerCurve(void) const {
+        std::ostringstream curve;
+        for (std::size_t i = 0; i < m_perCurve.size(); i++) {
+            curve << (i > 0 ? "," : "") << m_perCurve[i].first << ":" << m_perCurve[i].second;
+        }
+        return curve.str();
+    }
+
+    double MosaicAnalyticalChannel::GetCellSize(void) const {
+        return m_grid.GetCellSize();
+    }
+
+    void MosaicAnalyticalChannel::SetCellSize(double cellSize) {
+        m_grid.SetCellSize(cellSize);
+    }
+}
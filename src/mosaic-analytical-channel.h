@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) 2020 Fraunhofer FOKUS and others. All rights reserved.
+ *
+ * Contact: mosaic@fokus.fraunhofer.de
+ *
+ * This class is developed for the MOSAIC-NS-3 coupling.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+
+#ifndef MOSAIC_ANALYTICAL_CHANNEL_H
+#define MOSAIC_ANALYTICAL_CHANNEL_H
+
+#include <functional>
+#include <queue>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "ns3/callback.h"
+#include "ns3/data-rate.h"
+#include "ns3/nstime.h"
+#include "ns3/object.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/vector.h"
+#include "mosaic-spatial-grid.h"
+
+namespace ns3 {
+
+    /**
+     * @class MosaicAnalyticalChannel
+     * @brief Radio backend of the ANALYTICAL communication type. There is no PHY, MAC or IP
+     * stack and no ns-3 node, the channel only knows the positions of the MOSAIC nodes.
+     *
+     * A transmission reaches every node with an enabled radio within Range of the sender.
+     * Each receiver drops it with the packet error rate of its distance, taken from a
+     * piecewise linear PER curve. The survivors receive it after Latency plus the
+     * serialization time of the payload at DataRate, all of them in one event.
+     * Every transmission is a broadcast, destination addresses are not evaluated.
+     */
+    class MosaicAnalyticalChannel : public Object {
+    public:
+        static TypeId GetTypeId(void);
+
+        MosaicAnalyticalChannel();
+        virtual ~MosaicAnalyticalChannel() = default;
+
+        /**
+         * @brief called for every successful reception with the MOSAIC id of the receiver and the message id
+         */
+        typedef Callback<void, uint32_t, uint32_t> ReceiveCallback;
+
+        void SetReceiveCallback(ReceiveCallback callback);
+
+        /**
+         * @brief add a node or move it, nodes are added with their radio enabled
+         */
+        void UpdatePosition(uint32_t nodeId, const Vector &position);
+
+        void Remove(uint32_t nodeId);
+
+        bool Contains(uint32_t nodeId) const;
+
+        /**
+         * @brief a node with a disabled radio neither sends nor receives
+         */
+        void SetRadioEnabled(uint32_t nodeId, bool enabled);
+
+        /**
+         * @brief send a message from the node to all nodes within range
+         *
+         * @param nodeId MOSAIC id of the sender
+         * @param msgID id of the message
+         * @param payLength payload length in bytes
+         */
+        void Send(uint32_t nodeId, uint32_t msgID, uint32_t payLength);
+
+        /**
+         * @brief the delay of a transmission without payload, the lower bound of every reception
+         */
+        Time GetLatency(void) const;
+
+        /**
+         * @brief time of the earliest delivery which is still pending, Time::Max() if there is none
+         */
+        Time GetNextDelivery(void) const;
+
+        int64_t AssignStreams(int64_t stream);
+
+    private:
+        virtual void DoDispose(void);
+
+        void Deliver(std::vector<uint32_t> receivers, uint32_t msgID);
+
+        /**
+         * @brief drop the times of the deliveries which are over
+         */
+        void DropPastDeliveries(void) const;
+
+        /**
+         * @brief packet error rate at the given distance, linear between the points of the curve
+         */
+        double GetPer(double distance) const;
+
+        void SetPerCurve(std::string curve);
+        std::string GetPerCurve(void) const;
+
+        double GetCellSize(void) const;
+        void SetCellSize(double cellSize);
+
+        MosaicSpatialGrid m_grid;
+        std::unordered_set<uint32_t> m_radioOff;
+        double m_range;
+        Time m_latency;
+        DataRate m_dataRate;
+        // points (distance, per) sorted by distance
+        std::vector<std::pair<double, double>> m_perCurve;
+        Ptr<UniformRandomVariable> m_random;
+        ReceiveCallback m_receiveCallback;
+
+        // scratch buffer of the nodes in range of the current transmission
+        std::vector<uint32_t> m_inRange;
+
+        // times of the scheduled deliveries, the ones in the past are dropped on every send and query
+        mutable std::priority_queue<Time, std::vector<Time>, std::greater<Time>> m_deliveries;
+    };
+}
+#endif
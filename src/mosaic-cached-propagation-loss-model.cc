@@ -0,0 +1,248 @@
+/*
+ * Copyright (c) 2020 Fraunhofer FOKUS and others. All rights reserved.
+ *
+ * Contact: mosaic@fokus.fraunhofer.de
+ *
+ * This class is developed for the MOSAIC-NS-3 coupling.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "mosaic-cached-propagation-loss-model.h"
+
+#include "ns3/double.h"
+#include "ns3/log.h"
+#include "ns3/pointer.h"
+#include "ns3/string.h"
+#include "ns3/uinteger.h"
+
+#include <cmath>
+#include <set>
+
+NS_LOG_COMPONENT_DEFINE("MosaicCachedPropagationLossModel");
+
+namespace ns3 {
+
+    NS_OBJECT_ENSURE_REGISTERED(MosaicStaticNodeRegistry);
+    NS_OBJECT_ENSURE_REGISTERED(MosaicCachedPropagationLossModel);
+
+    TypeId MosaicStaticNodeRegistry::GetTypeId(void) {
+        static TypeId tid = TypeId("ns3::MosaicStaticNodeRegistry")
+                .SetParent<Object>()
+                .AddConstructor<MosaicStaticNodeRegistry>();
+        return tid;
+    }
+
+    void MosaicStaticNodeRegistry::Register(Ptr<const MobilityModel> mobility) {
+        m_nodes[PeekPointer(mobility)] = StaticNode{mobility, m_nextGeneration++};
+    }
+
+    void MosaicStaticNodeRegistry::Unregister(Ptr<const MobilityModel> mobility) {
+        m_nodes.erase(PeekPointer(mobility));
+    }
+
+    void MosaicStaticNodeRegistry::Invalidate(Ptr<const MobilityModel> mobility) {
+        auto it = m_nodes.find(PeekPointer(mobility));
+        if (it != m_nodes.end()) {
+            it->second.generation = m_nextGeneration++;
+        }
+    }
+
+    uint64_t MosaicStaticNodeRegistry::GetHits(void) const {
+        return m_hits;
+    }
+
+    uint64_t MosaicStaticNodeRegistry::GetMisses(void) const {
+        return m_misses;
+    }
+
+    const MosaicStaticNodeRegistry::StaticNode *MosaicStaticNodeRegistry::Find(const MobilityModel *mobility) const {
+        auto it = m_nodes.find(mobility);
+        return it == m_nodes.end() ? nullptr : &it->second;
+    }
+
+    void MosaicStaticNodeRegistry::DoDispose(void) {
+        NS_LOG_INFO("Path loss cache: " << m_hits << " hits, " << m_misses << " misses");
+        m_nodes.clear();
+        Object::DoDispose();
+    }
+
+    TypeId MosaicCachedPropagationLossModel::GetTypeId(void) {
+        static TypeId tid = TypeId("ns3::MosaicCachedPropagationLossModel")
+                .SetParent<PropagationLossModel>()
+                .AddConstructor<MosaicCachedPropagationLossModel>()
+                .AddAttribute("ModelType", "Type of the wrapped loss model",
+                StringValue(""),
+                MakeStringAccessor(&MosaicCachedPropagationLossModel::SetModelType, &MosaicCachedPropagationLossModel::GetModelType),
+                MakeStringChecker())
+                .AddAttribute("Model", "The wrapped loss model",
+                PointerValue(),
+                MakePointerAccessor(&MosaicCachedPropagationLossModel::SetModel, &MosaicCachedPropagationLossModel::GetModel),
+                MakePointerChecker<PropagationLossModel>())
+                .AddAttribute("Frequency", "Carrier frequency in Hz, forwarded to the wrapped model if it has such an attribute",
+                DoubleValue(2.1e9),
+                MakeDoubleAccessor(&MosaicCachedPropagationLossModel::SetFrequency, &MosaicCachedPropagationLossModel::GetFrequency),
+                MakeDoubleChecker<double>())
+                .AddAttribute("Resolution", "Edge length in meters of the cells the positions of the non static nodes are quantized to",
+                DoubleValue(1.0),
+                MakeDoubleAccessor(&MosaicCachedPropagationLossModel::m_resolution),
+                MakeDoubleChecker<double>(0.01))
+                .AddAttribute("MaxCells", "Maximum number of cells cached per static node, the least recently used cell "
+                "is dropped first, 0 does not bound the cache",
+                UintegerValue(65536),
+                MakeUintegerAccessor(&MosaicCachedPropagationLossModel::m_maxCells),
+                MakeUintegerChecker<uint32_t>())
+                .AddAttribute("StaticNodes", "Registry of the static nodes whose links are cached, nothing is cached without one",
+                PointerValue(),
+                MakePointerAccessor(&MosaicCachedPropagationLossModel::m_staticNodes),
+                MakePointerChecker<MosaicStaticNodeRegistry>());
+        return tid;
+    }
+
+    MosaicCachedPropagationLossModel::MosaicCachedPropagationLossModel() : m_frequency(2.1e9), m_resolution(1.0), m_maxCells(65536), m_deterministic(false) {
+    }
+
+    void MosaicCachedPropagationLossModel::SetModel(Ptr<PropagationLossModel> model) {
+        m_model = model;
+        m_deterministic = model != nullptr && IsDeterministic(model);
+        if (model != nullptr && !m_deterministic) {
+            NS_LOG_INFO(model->GetInstanceTypeId().GetName() << " is not known to be deterministic, its loss is not cached");
+        }
+        m_cache.clear();
+    }
+
+    Ptr<PropagationLossModel> MosaicCachedPropagationLossModel::GetModel(void) const {
+        return m_model;
+    }
+
+    void MosaicCachedPropagationLossModel::SetModelType(std::string type) {
+        m_modelType = type;
+        if (type.empty()) {
+            return;
+        }
+        ObjectFactory factory;
+        factory.SetTypeId(type);
+        SetModel(factory.Create<PropagationLossModel>());
+    }
+
+    std::string MosaicCachedPropagationLossModel::GetModelType(void) const {
+        return m_modelType;
+    }
+
+    void MosaicCachedPropagationLossModel::SetFrequency(double frequency) {
+        m_frequency = frequency;
+        if (m_model != nullptr) {
+            m_model->SetAttributeFailSafe("Frequency", DoubleValue(frequency));
+            m_cache.clear();
+        }
+    }
+
+    double MosaicCachedPropagationLossModel::GetFrequency(void) const {
+        return m_frequency;
+    }
+
+    uint64_t MosaicCachedPropagationLossModel::GetCellKey(const Vector &position, bool staticIsSender) const {
+        // 21 bits per axis cover +-1000 km at the default resolution
+        const uint64_t mask = (1u << 21) - 1;
+        const uint64_t x = static_cast<uint64_t> (static_cast<int64_t> (std::floor(position.x / m_resolution))) & mask;
+        const uint64_t y = static_cast<uint64_t> (static_cast<int64_t> (std::floor(position.y / m_resolution))) & mask;
+        const uint64_t z = static_cast<uint64_t> (static_cast<int64_t> (std::floor(position.z / m_resolution))) & mask;
+        return (x << 43) | (y << 22) | (z << 1) | (staticIsSender ? 1 : 0);
+    }
+
+    bool MosaicCachedPropagationLossModel::IsDeterministic(Ptr<PropagationLossModel> model) {
+        // the models of the propagation module which draw no random variables
+        static const std::set<std::string> deterministic = {
+            "ns3::FriisPropagationLossModel",
+            "ns3::TwoRayGroundPropagationLossModel",
+            "ns3::LogDistancePropagationLossModel",
+            "ns3::ThreeLogDistancePropagationLossModel",
+            "ns3::RangePropagationLossModel",
+            "ns3::FixedRssLossModel",
+            "ns3::MatrixPropagationLossModel",
+            "ns3::Cost231PropagationLossModel",
+            "ns3::OkumuraHataPropagationLossModel",
+            "ns3::ItuR1411LosPropagationLossModel",
+            "ns3::ItuR1411NlosOverRooftopPropagationLossModel",
+            "ns3::Kun2600MhzPropagationLossModel"
+        };
+        for (; model != nullptr; model = model->GetNext()) {
+            if (deterministic.count(model->GetInstanceTypeId().GetName()) == 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    double MosaicCachedPropagationLossModel::DoCalcRxPower(double txPowerDbm, Ptr<MobilityModel> a, Ptr<MobilityModel> b) const {
+        NS_ASSERT_MSG(m_model != nullptr, "no loss model to wrap, set ModelType or Model");
+        if (!m_deterministic || m_staticNodes == nullptr) {
+            return m_model->CalcRxPower(txPowerDbm, a, b);
+        }
+
+        // cache on the static end of the link, the sender if both ends are static
+        const MobilityModel *staticNode = PeekPointer(a);
+        const MosaicStaticNodeRegistry::StaticNode *node = m_staticNodes->Find(staticNode);
+        bool staticIsSender = true;
+        if (node == nullptr) {
+            staticNode = PeekPointer(b);
+            node = m_staticNodes->Find(staticNode);
+            staticIsSender = false;
+        }
+        if (node == nullptr) {
+            return m_model->CalcRxPower(txPowerDbm, a, b);
+        }
+
+        const Vector other = staticIsSender ? b->GetPosition() : a->GetPosition();
+        const uint64_t cellKey = GetCellKey(other, staticIsSender);
+        NodeCache &cache = m_cache[staticNode];
+        auto cell = cache.cells.find(cellKey);
+        if (cell != cache.cells.end()) {
+            cache.entries.splice(cache.entries.begin(), cache.entries, cell->second);
+            if (cell->second->generation == node->generation) {
+                m_staticNodes->m_hits++;
+                return txPowerDbm - cell->second->lossDb;
+            }
+        }
+        m_staticNodes->m_misses++;
+        const double rxPowerDbm = m_model->CalcRxPower(txPowerDbm, a, b);
+        if (cell != cache.cells.end()) {
+            cell->second->generation = node->generation;
+            cell->second->lossDb = txPowerDbm - rxPowerDbm;
+            return rxPowerDbm;
+        }
+        if (m_maxCells > 0 && cache.cells.size() >= m_maxCells) {
+            cache.cells.erase(cache.entries.back().cellKey);
+            cache.entries.pop_back();
+        }
+        cache.entries.push_front(CacheEntry{cellKey, node->generation, txPowerDbm - rxPowerDbm});
+        cache.cells[cellKey] = cache.entries.begin();
+        return rxPowerDbm;
+    }
+
+    int64_t MosaicCachedPropagationLossModel::DoAssignStreams(int64_t stream) {
+        if (m_model == nullptr) {
+            return 0;
+        }
+        return m_model->AssignStreams(stream);
+    }
+
+    void MosaicCachedPropagationLossModel::DoDispose(void) {
+        m_cache.clear();
+        m_staticNodes = nullptr;
+        m_model = nullptr;
+        PropagationLossModel::DoDispose();
+    }
+}
@@ -0,0 +1,164 @@
+/*
+ * Copyright (c) 2020 Fraunhofer FOKUS and others. All rights reserved.
+ *
+ * Contact: mosaic@fokus.fraunhofer.de
+ *
+ * This class is developed for the MOSAIC-NS-3 coupling.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+
+#ifndef MOSAIC_CACHED_PROPAGATION_LOSS_MODEL_H
+#define MOSAIC_CACHED_PROPAGATION_LOSS_MODEL_H
+
+#include <list>
+#include <unordered_map>
+
+#include "ns3/mobility-model.h"
+#include "ns3/object-factory.h"
+#include "ns3/propagation-loss-model.h"
+
+namespace ns3 {
+
+    /**
+     * @class MosaicStaticNodeRegistry
+     * @brief The nodes which do not move, i.e. RSUs and eNBs, shared by the loss models of one
+     * federate. The LteHelper creates the loss models itself, the registry is handed to them
+     * with the StaticNodes attribute of MosaicCachedPropagationLossModel.
+     */
+    class MosaicStaticNodeRegistry : public Object {
+    public:
+        static TypeId GetTypeId(void);
+
+        MosaicStaticNodeRegistry() = default;
+        virtual ~MosaicStaticNodeRegistry() = default;
+
+        /**
+         * @brief mark the node owning the mobility model as static, its links are cached from now on
+         */
+        void Register(Ptr<const MobilityModel> mobility);
+
+        /**
+         * @brief stop caching the links of a node, e.g. when it was removed
+         */
+        void Unregister(Ptr<const MobilityModel> mobility);
+
+        /**
+         * @brief drop all cached links of a static node
+         */
+        void Invalidate(Ptr<const MobilityModel> mobility);
+
+        /**
+         * @brief number of links answered from the cache by all models using this registry
+         */
+        uint64_t GetHits(void) const;
+
+        /**
+         * @brief number of cacheable links which had to be evaluated by all models using this registry
+         */
+        uint64_t GetMisses(void) const;
+
+    private:
+        friend class MosaicCachedPropagationLossModel;
+
+        struct StaticNode {
+            // keeps the address of the model from being reused while it is registered
+            Ptr<const MobilityModel> mobility;
+            uint32_t generation;
+        };
+
+        virtual void DoDispose(void);
+
+        /**
+         * @return the registered node or nullptr
+         */
+        const StaticNode *Find(const MobilityModel *mobility) const;
+
+        std::unordered_map<const MobilityModel *, StaticNode> m_nodes;
+        // generations are never reused, so entries cached for a former registration never match
+        uint32_t m_nextGeneration = 1;
+        uint64_t m_hits = 0;
+        uint64_t m_misses = 0;
+    };
+
+    /**
+     * @class MosaicCachedPropagationLossModel
+     * @brief Wraps another loss model and memoizes its loss for links to the nodes of a
+     * MosaicStaticNodeRegistry. The loss is cached per static node and per cell of the other
+     * end of the link, the cell edge is given by the Resolution attribute. The first position
+     * evaluated in a cell stands for the whole cell. The MaxCells attribute bounds the cells kept
+     * per static node, the least recently used cell is dropped first.
+     *
+     * Only deterministic models are cached, a model drawing random variables, e.g. for
+     * shadowing or the LOS condition, is passed through, as is every model without a
+     * registry. Links between two moving nodes are always passed through to the wrapped model.
+     */
+    class MosaicCachedPropagationLossModel : public PropagationLossModel {
+    public:
+        static TypeId GetTypeId(void);
+
+        MosaicCachedPropagationLossModel();
+        virtual ~MosaicCachedPropagationLossModel() = default;
+
+        void SetModel(Ptr<PropagationLossModel> model);
+        Ptr<PropagationLossModel> GetModel(void) const;
+
+    private:
+        struct CacheEntry {
+            uint64_t cellKey;
+            uint32_t generation;
+            double lossDb;
+        };
+
+        /**
+         * @brief the cached cells of one static node, the most recently used cell first
+         */
+        struct NodeCache {
+            std::list<CacheEntry> entries;
+            std::unordered_map<uint64_t, std::list<CacheEntry>::iterator> cells;
+        };
+
+        virtual double DoCalcRxPower(double txPowerDbm, Ptr<MobilityModel> a, Ptr<MobilityModel> b) const;
+        virtual int64_t DoAssignStreams(int64_t stream);
+        virtual void DoDispose(void);
+
+        void SetModelType(std::string type);
+        std::string GetModelType(void) const;
+        void SetFrequency(double frequency);
+        double GetFrequency(void) const;
+
+        /**
+         * @brief check whether the model and all models chained to it are free of random draws
+         */
+        static bool IsDeterministic(Ptr<PropagationLossModel> model);
+
+        /**
+         * @brief key of the cell of a position combined with the direction of the link
+         */
+        uint64_t GetCellKey(const Vector &position, bool staticIsSender) const;
+
+        Ptr<PropagationLossModel> m_model;
+        std::string m_modelType;
+        double m_frequency;
+        double m_resolution;
+        uint32_t m_maxCells;
+        bool m_deterministic;
+        Ptr<MosaicStaticNodeRegistry> m_staticNodes;
+
+        mutable std::unordered_map<const MobilityModel *, NodeCache> m_cache;
+    };
+}
+#endif
@@ -0,0 +1,179 @@
+/*
+ * Copyright (c) 2020 Fraunhofer FOKUS and others. All rights reserved.
+ *
+ * Contact: mosaic@fokus.fraunhofer.de
+ *
+ * This class is developed for the MOSAIC-NS-3 coupling.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+
+#include "mosaic-federate-c.h"
+
+#include "mosaic-federate.h"
+#include "ns3/global-value.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/string.h"
+
+NS_LOG_COMPONENT_DEFINE("MosaicFederateC");
+
+using namespace ns3;
+
+struct mosaic_federate {
+    explicit mosaic_federate(const FederateConfig &config) : federate(config) {
+    }
+
+    MosaicFederate federate;
+    bool started = false;
+};
+
+// the simulator is a singleton, so is the federate
+static bool s_federateExists = false;
+
+// commands are scheduled relative to the current time, the past cannot be scheduled
+static bool CanSchedule(const mosaic_federate *federate, uint64_t time) {
+    if (!federate->started) {
+        return false;
+    }
+    if (time < federate->federate.Now()) {
+        NS_LOG_WARN("Rejecting command at " << time << ", the simulation is already at " << federate->federate.Now());
+        return false;
+    }
+    return true;
+}
+
+extern "C" {
+
+    mosaic_federate *mosaic_federate_create(int comm_type, int num_lte_nodes) {
+        if (s_federateExists) {
+            NS_LOG_ERROR("There is already a federate in this process");
+            return nullptr;
+        }
+        if (comm_type != CommunicationType::DSRC && comm_type != CommunicationType::LTE
+                && comm_type != CommunicationType::ANALYTICAL) {
+            NS_LOG_ERROR("Unknown communication type:" << comm_type);
+            return nullptr;
+        }
+        GlobalValue::Bind("SchedulerType", StringValue("ns3::ListScheduler"));
+        GlobalValue::Bind("SimulatorImplementationType", StringValue("ns3::MosaicSimulatorImpl"));
+
+        FederateConfig config;
+        config.commType = static_cast<CommunicationType> (comm_type);
+        config.numOfNodes = num_lte_nodes;
+        mosaic_federate *federate = new mosaic_federate(config);
+        s_federateExists = true;
+        return federate;
+    }
+
+    void mosaic_federate_destroy(mosaic_federate *federate) {
+        if (federate == nullptr) {
+            return;
+        }
+        Simulator::Destroy();
+        delete federate;
+        s_federateExists = false;
+    }
+
+    void mosaic_federate_set_next_event_callback(mosaic_federate *federate, mosaic_next_event_fn callback, void *user_data) {
+        if (callback == nullptr) {
+            federate->federate.SetNextEventCallback(nullptr);
+            return;
+        }
+        federate->federate.SetNextEventCallback([callback, user_data](uint64_t time) { callback(user_data, time); });
+    }
+
+    void mosaic_federate_set_receive_callback(mosaic_federate *federate, mosaic_receive_fn callback, void *user_data) {
+        if (callback == nullptr) {
+            federate->federate.SetReceiveCallback(nullptr);
+            return;
+        }
+        federate->federate.SetReceiveCallback([callback, user_data](uint64_t time, uint32_t nodeId, int msgID) {
+            callback(user_data, time, nodeId, msgID);
+        });
+    }
+
+    void mosaic_federate_set_command_error_callback(mosaic_federate *federate, mosaic_command_error_fn callback, void *user_data) {
+        if (callback == nullptr) {
+            federate->federate.SetCommandErrorCallback(nullptr);
+            return;
+        }
+        federate->federate.SetCommandErrorCallback([callback, user_data](uint32_t msgID) { callback(user_data, msgID); });
+    }
+
+    int mosaic_federate_start(mosaic_federate *federate, uint64_t end_time) {
+        if (federate->started || !federate->federate.Start(end_time)) {
+            return -1;
+        }
+        federate->started = true;
+        return 0;
+    }
+
+    int mosaic_federate_add_node(mosaic_federate *federate, uint64_t time, uint32_t node_id, double x, double y, int is_rsu) {
+        if (!CanSchedule(federate, time)) {
+            return -1;
+        }
+        federate->federate.AddNode(time, node_id, Vector(x, y, 0.0), is_rsu != 0);
+        return 0;
+    }
+
+    int mosaic_federate_move_node(mosaic_federate *federate, uint64_t time, uint32_t node_id, double x, double y) {
+        if (!CanSchedule(federate, time)) {
+            return -1;
+        }
+        federate->federate.MoveNode(time, node_id, Vector(x, y, 0.0));
+        return 0;
+    }
+
+    int mosaic_federate_remove_node(mosaic_federate *federate, uint64_t time, uint32_t node_id) {
+        if (!CanSchedule(federate, time)) {
+            return -1;
+        }
+        federate->federate.RemoveNode(time, node_id);
+        return 0;
+    }
+
+    int mosaic_federate_configure_radio(mosaic_federate *federate, uint64_t time, uint32_t node_id, int turned_on, int tx_power, uint32_t message_id) {
+        if (!CanSchedule(federate, time)) {
+            return -1;
+        }
+        federate->federate.ConfigureRadio(time, node_id, turned_on != 0, tx_power, message_id);
+        return 0;
+    }
+
+    int mosaic_federate_send(mosaic_federate *federate, uint64_t time, uint32_t node_id, uint32_t message_id, uint32_t length, uint32_t destination) {
+        if (!CanSchedule(federate, time)) {
+            return -1;
+        }
+        federate->federate.Send(time, node_id, message_id, length, Ipv4Address(destination));
+        return 0;
+    }
+
+    uint64_t mosaic_federate_advance_time(mosaic_federate *federate, uint64_t time) {
+        if (!federate->started) {
+            return 0;
+        }
+        return federate->federate.AdvanceTime(time);
+    }
+
+    int mosaic_federate_is_finished(const mosaic_federate *federate) {
+        return federate->federate.IsFinished() ? 1 : 0;
+    }
+
+    int64_t mosaic_federate_get_lookahead(const mosaic_federate *federate, uint64_t time) {
+        return federate->federate.GetLookahead(time);
+    }
+}
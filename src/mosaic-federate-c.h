@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2020 Fraunhofer FOKUS and others. All rights reserved.
+ *
+ * Contact: mosaic@fokus.fraunhofer.de
+ *
+ * This class is developed for the MOSAIC-NS-3 coupling.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+
+#ifndef MOSAIC_FEDERATE_C_H
+#define MOSAIC_FEDERATE_C_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief C API of the in-process federate, see MosaicFederate
+ *
+ * All times are absolute simulation times in nanoseconds. Functions returning int
+ * return 0 on success and -1 on error. Commands for a time before the current
+simulation time fail. The ns-3 simulator is a process wide
+ * singleton, hence only one federate can exist per process and the functions must
+ * be called from one thread. ns-3 attributes are configured as usual before the
+ * federate is created, e.g. with Config::SetDefault or a ConfigStore.
+ */
+typedef struct mosaic_federate mosaic_federate;
+
+enum mosaic_comm_type {
+    MOSAIC_COMM_DSRC = 1,
+    MOSAIC_COMM_LTE = 2,
+    MOSAIC_COMM_ANALYTICAL = 3
+};
+
+/** @brief called for every scheduled event */
+typedef void (*mosaic_next_event_fn)(void *user_data, uint64_t time);
+/** @brief called for every message received by a node, message_id is -1 for packets without id */
+typedef void (*mosaic_receive_fn)(void *user_data, uint64_t time, uint32_t node_id, int32_t message_id);
+/** @brief called for send and radio configuration commands which could not be executed */
+typedef void (*mosaic_command_error_fn)(void *user_data, uint32_t message_id);
+
+/**
+ * @brief create the federate and select the MOSAIC simulator implementation
+ *
+ * @param comm_type one of mosaic_comm_type
+ * @param num_lte_nodes number of UEs created up front for LTE, ignored otherwise
+ * @return the federate, NULL if the type is unknown or a federate already exists
+ */
+mosaic_federate *mosaic_federate_create(int comm_type, int num_lte_nodes);
+
+/**
+ * @brief destroy the federate and the ns-3 simulator
+ */
+void mosaic_federate_destroy(mosaic_federate *federate);
+
+void mosaic_federate_set_next_event_callback(mosaic_federate *federate, mosaic_next_event_fn callback, void *user_data);
+void mosaic_federate_set_receive_callback(mosaic_federate *federate, mosaic_receive_fn callback, void *user_data);
+void mosaic_federate_set_command_error_callback(mosaic_federate *federate, mosaic_command_error_fn callback, void *user_data);
+
+/**
+ * @brief set up the network, must be called once before any node is added
+ *
+ * @param end_time end of the simulation
+ */
+int mosaic_federate_start(mosaic_federate *federate, uint64_t end_time);
+
+int mosaic_federate_add_node(mosaic_federate *federate, uint64_t time, uint32_t node_id, double x, double y, int is_rsu);
+int mosaic_federate_move_node(mosaic_federate *federate, uint64_t time, uint32_t node_id, double x, double y);
+int mosaic_federate_remove_node(mosaic_federate *federate, uint64_t time, uint32_t node_id);
+
+/**
+ * @param tx_power tx power in dBm, -1 keeps the configured power
+ */
+int mosaic_federate_configure_radio(mosaic_federate *federate, uint64_t time, uint32_t node_id, int turned_on, int tx_power, uint32_t message_id);
+
+/**
+ * @param destination IPv4 destination address in host byte order
+ */
+int mosaic_federate_send(mosaic_federate *federate, uint64_t time, uint32_t node_id, uint32_t message_id, uint32_t length, uint32_t destination);
+
+/**
+ * @brief run all events up to and including the given time
+ *
+ * @return the simulation time reached
+ */
+uint64_t mosaic_federate_advance_time(mosaic_federate *federate, uint64_t time);
+
+/**
+ * @return 1 once the end time has been reached
+ */
+int mosaic_federate_is_finished(const mosaic_federate *federate);
+
+/**
+ * @brief no message is received before time plus the returned lookahead
+ *
+ * @param time the time of the next event or the time reached by the last advance
+ * @return the lookahead in nanoseconds, -1 before the start
+ */
+int64_t mosaic_federate_get_lookahead(const mosaic_federate *federate, uint64_t time);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
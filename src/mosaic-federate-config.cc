@@ -0,0 +1,205 @@
+/*
+ * Copyright (c) 2020 Fraunhofer FOKUS and others. All rights reserved.
+ *
+ * Contact: mosaic@fokus.fraunhofer.de
+ *
+ * This class is developed for the MOSAIC-NS-3 coupling.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+
+#include "mosaic-federate-config.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <libxml2/libxml/xmlreader.h>
+
+namespace ns3 {
+
+    static std::string GetAttribute(xmlTextReaderPtr reader, const char *name) {
+        std::string value;
+        xmlChar *attr = xmlTextReaderGetAttribute(reader, (const xmlChar *) name);
+        if (attr != nullptr) {
+            value.assign((char *) attr);
+            xmlFree(attr);
+        }
+        return value;
+    }
+
+    static double GetDoubleAttribute(xmlTextReaderPtr reader, const char *name, double defaultValue) {
+        std::string value = GetAttribute(reader, name);
+        return value.empty() ? defaultValue : std::atof(value.c_str());
+    }
+
+    static bool GetBoolAttribute(xmlTextReaderPtr reader, const char *name, bool defaultValue) {
+        std::string value = GetAttribute(reader, name);
+        return value.empty() ? defaultValue : !(value == "false" || value == "0");
+    }
+
+    static void ReadNetworkComponent(xmlTextReaderPtr reader, FederateConfig &config) {
+        std::string name = GetAttribute(reader, "name");
+        std::string value = GetAttribute(reader, "value");
+        if (name == "CommType") {
+            if (value == "DSRC") {
+                config.commType = ClientServerChannelSpace::CommunicationType::DSRC;
+            } else if (value == "LTE") {
+                config.commType = ClientServerChannelSpace::CommunicationType::LTE;
+            } else if (value == "ANALYTICAL") {
+                config.commType = ClientServerChannelSpace::CommunicationType::ANALYTICAL;
+            } else {
+                std::cerr << "Unknown communication type [" << value << "]" << std::endl;
+            }
+        } else if (name == "NumOfNodes") {
+            config.numOfNodes = std::atoi(value.c_str());
+        }
+    }
+
+    static void ReadLteTopologyComponent(xmlTextReaderPtr reader, LteTopologyConfig &topology) {
+        std::string name = GetAttribute(reader, "name");
+        if (name == "Grid") {
+            int rows = std::atoi(GetAttribute(reader, "rows").c_str());
+            int columns = std::atoi(GetAttribute(reader, "columns").c_str());
+            double spacing = GetDoubleAttribute(reader, "spacing", 500.0);
+            Vector origin(GetDoubleAttribute(reader, "x", 0.0), GetDoubleAttribute(reader, "y", 0.0), GetDoubleAttribute(reader, "z", 30.0));
+            for (int row = 0; row < rows; row++) {
+                for (int column = 0; column < columns; column++) {
+                    topology.sites.push_back(Vector(origin.x + column * spacing, origin.y + row * spacing, origin.z));
+                }
+            }
+        } else if (name == "Site") {
+            topology.sites.push_back(Vector(GetDoubleAttribute(reader, "x", 0.0), GetDoubleAttribute(reader, "y", 0.0), GetDoubleAttribute(reader, "z", 30.0)));
+        } else if (name == "Handover") {
+            topology.handover = GetBoolAttribute(reader, "value", true);
+        } else {
+            std::cerr << "Unknown LteTopology component [" << name << "]" << std::endl;
+        }
+    }
+
+    static void ReadSidelinkPool(xmlTextReaderPtr reader, SidelinkPreset &preset) {
+        SidelinkPoolConfig pool;
+        std::string value = GetAttribute(reader, "slSubframe");
+        if (!value.empty()) {
+            pool.slSubframe = std::strtoul(value.c_str(), nullptr, 0);
+        }
+        pool.adjacencyPscchPssch = GetBoolAttribute(reader, "adjacencyPscchPssch", pool.adjacencyPscchPssch);
+        pool.sizeSubchannel = GetDoubleAttribute(reader, "sizeSubchannel", pool.sizeSubchannel);
+        pool.numSubchannel = GetDoubleAttribute(reader, "numSubchannel", pool.numSubchannel);
+        pool.startRbSubchannel = GetDoubleAttribute(reader, "startRbSubchannel", pool.startRbSubchannel);
+        pool.startRbPscchPool = GetDoubleAttribute(reader, "startRbPscchPool", pool.startRbPscchPool);
+        pool.dataTxP0 = GetDoubleAttribute(reader, "dataTxP0", pool.dataTxP0);
+        pool.dataTxAlpha = GetDoubleAttribute(reader, "dataTxAlpha", pool.dataTxAlpha);
+
+        std::string direction = GetAttribute(reader, "direction");
+        if (direction != "rx") {
+            preset.txPools.push_back(pool);
+        }
+        if (direction != "tx") {
+            preset.rxPools.push_back(pool);
+        }
+    }
+
+    bool LoadFederateConfig(const std::string &configFile, FederateConfig &config) {
+        xmlTextReaderPtr reader = xmlReaderForFile(configFile.c_str(), nullptr, XML_PARSE_NONET);
+        if (reader == nullptr) {
+            std::cerr << "Could not open configuration file \"" << configFile << "\"" << std::endl;
+            return false;
+        }
+
+        // names of the open elements, the settings are identified by their parent
+        std::vector<std::string> path;
+        // the preset being read, stored when its element closes
+        std::string presetName;
+        SidelinkPreset preset;
+
+        int result;
+        while ((result = xmlTextReaderRead(reader)) == 1) {
+            const int type = xmlTextReaderNodeType(reader);
+            if (type == XML_READER_TYPE_END_ELEMENT) {
+                if (path.back() == "Preset" && !presetName.empty()) {
+                    config.sidelink.presets[presetName] = preset;
+                }
+                path.pop_back();
+                continue;
+            }
+            if (type != XML_READER_TYPE_ELEMENT) {
+                continue;
+            }
+
+            const std::string name((const char *) xmlTextReaderConstName(reader));
+            const std::string parent = path.empty() ? "" : path.back();
+            if (name == "default") {
+                config.defaults.push_back({GetAttribute(reader, "name"), GetAttribute(reader, "value")});
+            } else if (name == "global") {
+                config.globals.push_back({GetAttribute(reader, "name"), GetAttribute(reader, "value")});
+            } else if (name == "value") {
+                config.values.push_back({GetAttribute(reader, "path"), GetAttribute(reader, "value")});
+            } else if (name == "component" && parent == "LogLevel") {
+                LogLevelConfig logLevel{GetAttribute(reader, "name"), GetAttribute(reader, "value")};
+                if (logLevel.component.empty() || logLevel.level.empty()) {
+                    std::cerr << "Could not parse log level for component [" << logLevel.component << "], level [" << logLevel.level << "]" << std::endl;
+                } else {
+                    config.logLevels.push_back(logLevel);
+                }
+            } else if (name == "component" && parent == "NetworkConfig") {
+                ReadNetworkComponent(reader, config);
+            } else if (name == "component" && parent == "LteTopology") {
+                ReadLteTopologyComponent(reader, config.lteTopology);
+            } else if (name == "Traces") {
+                std::string file = GetAttribute(reader, "file");
+                if (!file.empty()) {
+                    config.traces.file = file;
+                }
+                config.traces.flushInterval = GetDoubleAttribute(reader, "flushInterval", config.traces.flushInterval);
+                config.traces.blockRows = GetDoubleAttribute(reader, "blockRows", config.traces.blockRows);
+            } else if (name == "component" && parent == "Traces") {
+                std::string source = GetAttribute(reader, "name");
+                if (!source.empty()) {
+                    config.traces.sources.push_back(source);
+                }
+            } else if (name == "Sidelink") {
+                std::string active = GetAttribute(reader, "preset");
+                if (!active.empty()) {
+                    config.sidelink.preset = active;
+                }
+            } else if (name == "Preset" && parent == "Sidelink") {
+                presetName = GetAttribute(reader, "name");
+                preset = SidelinkPreset();
+                if (presetName.empty()) {
+                    std::cerr << "Sidelink preset without name is ignored" << std::endl;
+                }
+                preset.carrierFreq = GetDoubleAttribute(reader, "carrierFreq", preset.carrierFreq);
+                preset.slBandwidth = GetDoubleAttribute(reader, "slBandwidth", preset.slBandwidth);
+            } else if (name == "Pool" && parent == "Preset") {
+                ReadSidelinkPool(reader, preset);
+            }
+
+            if (xmlTextReaderIsEmptyElement(reader)) {
+                if (name == "Preset" && parent == "Sidelink" && !presetName.empty()) {
+                    config.sidelink.presets[presetName] = preset;
+                }
+            } else {
+                path.push_back(name);
+            }
+        }
+        xmlFreeTextReader(reader);
+
+        if (result != 0) {
+            std::cerr << "Could not parse configuration file \"" << configFile << "\"" << std::endl;
+            return false;
+        }
+        return true;
+    }
+}
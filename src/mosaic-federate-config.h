@@ -0,0 +1,183 @@
+/*
+ * Copyright (c) 2020 Fraunhofer FOKUS and others. All rights reserved.
+ *
+ * Contact: mosaic@fokus.fraunhofer.de
+ *
+ * This class is developed for the MOSAIC-NS-3 coupling.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef MOSAIC_FEDERATE_CONFIG_H
+#define MOSAIC_FEDERATE_CONFIG_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "ns3/vector.h"
+#include "ClientServerChannel.h"
+
+namespace ns3 {
+
+    /**
+     * @brief LTE cell layout, read from the LteTopology section of ns3_federate_config.xml
+     *
+     * <LteTopology>
+     *   <component name="Grid" rows="2" columns="3" spacing="500" x="0" y="0" z="30"/>
+     *   <component name="Site" x="5" y="-10" z="30"/>
+     *   <component name="Handover" value="true"/>
+     * </LteTopology>
+     *
+     * Grid sites and single sites are combined. Without any site the federate
+     * falls back to the single eNodeB at (5, -10, 30).
+     */
+    struct LteTopologyConfig {
+        std::vector<Vector> sites;
+        bool handover = true;
+    };
+
+    /**
+     * @brief one sidelink V2X resource pool, the defaults are the former hardcoded pool
+     */
+    struct SidelinkPoolConfig {
+        uint32_t slSubframe = 0xFFFFF;
+        bool adjacencyPscchPssch = true;
+        uint32_t sizeSubchannel = 10;
+        uint32_t numSubchannel = 3;
+        uint32_t startRbSubchannel = 0;
+        uint32_t startRbPscchPool = 0;
+        int32_t dataTxP0 = -4;
+        double dataTxAlpha = 0.9;
+    };
+
+    /**
+     * @brief sidelink V2X preconfiguration of the carrier, empty pool lists use one default pool
+     */
+    struct SidelinkPreset {
+        uint32_t carrierFreq = 54890;
+        uint32_t slBandwidth = 30;
+        std::vector<SidelinkPoolConfig> txPools;
+        std::vector<SidelinkPoolConfig> rxPools;
+        // reported as failed command if the update cannot be applied
+        bool hasMessageId = false;
+        uint32_t messageId = 0;
+    };
+
+    /**
+     * @brief change of the sidelink configuration, resolved against the preset active when it is
+     * applied, so changes scheduled for the same or later times build on each other
+     */
+    struct SidelinkUpdate {
+        // preset to start from, the active preset if empty
+        std::string preset;
+        bool hasCarrierFreq = false;
+        uint32_t carrierFreq = 0;
+        bool hasSlBandwidth = false;
+        uint32_t slBandwidth = 0;
+        // the pools replace the pools of the preset if both lists are set
+        std::vector<SidelinkPoolConfig> txPools;
+        std::vector<SidelinkPoolConfig> rxPools;
+    };
+
+    /**
+     * @brief named sidelink presets, read from the Sidelink section of ns3_federate_config.xml
+     *
+     * <Sidelink preset="dense">
+     *   <Preset name="dense" carrierFreq="54890" slBandwidth="50">
+     *     <Pool direction="both" slSubframe="0xFFFFF" adjacencyPscchPssch="true" sizeSubchannel="10"
+     *           numSubchannel="5" startRbSubchannel="0" startRbPscchPool="0" dataTxP0="-4" dataTxAlpha="0.9"/>
+     *   </Preset>
+     * </Sidelink>
+     *
+     * The preset "default" always exists and holds the former hardcoded configuration,
+     * it can be overridden in the file. The preset attribute selects the one used at start-up.
+     */
+    struct SidelinkConfig {
+        std::string preset = "default";
+        std::map<std::string, SidelinkPreset> presets = {{"default", SidelinkPreset()}};
+    };
+
+    /**
+     * @brief trace sources written to a binary trace file, read from the Traces section of ns3_federate_config.xml
+     *
+     * <Traces file="federate-traces.bin" flushInterval="5" blockRows="4096">
+     *   <component name="DlRxPhy"/>
+     *   <component name="RsrpSinr"/>
+     * </Traces>
+     *
+     * Without any component no file is written. See MosaicNodeManager::SetupTraces for the sources.
+     */
+    struct TraceConfig {
+        std::string file = "federate-traces.bin";
+        // wall clock seconds
+        double flushInterval = 5.0;
+        uint32_t blockRows = 4096;
+        std::vector<std::string> sources;
+    };
+
+    /**
+     * @brief one ns-3 attribute setting in the ConfigStore syntax, <default name="" value=""/>,
+     * <global name="" value=""/> or <value path="" value=""/>
+     */
+    struct AttributeConfig {
+        // attribute, global value or object path
+        std::string name;
+        std::string value;
+    };
+
+    /**
+     * @brief <LogLevel><component name="MosaicNodeManager" value="debug|prefix_time"/></LogLevel>
+     */
+    struct LogLevelConfig {
+        std::string component;
+        std::string level;
+    };
+
+    /**
+     * @brief everything the federate reads from ns3_federate_config.xml
+     *
+     * <NetworkConfig>
+     *   <component name="CommType" value="LTE"/>
+     *   <component name="NumOfNodes" value="100"/>
+     * </NetworkConfig>
+     *
+     * The tuning knobs of the federate are attributes, e.g.
+     * <default name="ns3::MosaicNodeManager::UePoolGrowth" value="32"/>.
+     */
+    struct FederateConfig {
+        // 0 if CommType is missing or unknown
+        ClientServerChannelSpace::CommunicationType commType = static_cast<ClientServerChannelSpace::CommunicationType> (0);
+        // UEs created up front in LTE mode, the pool grows on demand
+        int numOfNodes = 0;
+        LteTopologyConfig lteTopology;
+        SidelinkConfig sidelink;
+        TraceConfig traces;
+        std::vector<LogLevelConfig> logLevels;
+        std::vector<AttributeConfig> defaults;
+        std::vector<AttributeConfig> globals;
+        std::vector<AttributeConfig> values;
+    };
+
+    /**
+     * @brief read the config file in a single streaming pass
+     *
+     * @param configFile path of ns3_federate_config.xml
+     * @param config filled with the settings of the file, missing settings keep their defaults
+     * @return false, if the file could not be read or is malformed
+     */
+    bool LoadFederateConfig(const std::string &configFile, FederateConfig &config);
+}
+#endif
@@ -0,0 +1,198 @@
+/*
+ * Copyright (c) 2020 Fraunhofer FOKUS and others. All rights reserved.
+ *
+ * Contact: mosaic@fokus.fraunhofer.de
+ *
+ * This class is developed for the MOSAIC-NS-3 coupling.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+
+#include "mosaic-federate.h"
+
+#include "mosaic-logger.h"
+#include "mosaic-simulator-impl.h"
+#include "ns3/log.h"
+#include "ns3/make-event.h"
+#include "ns3/simulator.h"
+
+#include <chrono>
+#include <sys/resource.h>
+
+NS_LOG_COMPONENT_DEFINE("MosaicFederate");
+
+namespace ns3 {
+
+    /**
+     * @brief peak resident set size of the process in MB
+     */
+    static double GetMaxRssMb(void) {
+        struct rusage usage;
+        if (getrusage(RUSAGE_SELF, &usage) != 0) {
+            return 0.0;
+        }
+        // kilobytes on Linux
+        return usage.ru_maxrss / 1024.0;
+    }
+
+    MosaicFederate::MosaicFederate(const FederateConfig &config) : m_config(config) {
+        m_nodeManager = CreateObject<MosaicNodeManager>();
+        m_nodeManager->Configure(this, m_config);
+    }
+
+    MosaicFederate::~MosaicFederate() {
+        if (m_sim != nullptr) {
+            m_sim->AttachFederate(nullptr);
+        }
+        m_nodeManager->Configure(nullptr, m_config);
+        // flushes the trace file
+        m_nodeManager->Dispose();
+    }
+
+    void MosaicFederate::SetNextEventCallback(NextEventCallback callback) {
+        m_nextEventCallback = std::move(callback);
+    }
+
+    void MosaicFederate::SetReceiveCallback(ReceiveCallback callback) {
+        m_receiveCallback = std::move(callback);
+    }
+
+    void MosaicFederate::SetCommandErrorCallback(CommandErrorCallback callback) {
+        m_commandErrorCallback = std::move(callback);
+    }
+
+    bool MosaicFederate::Start(uint64_t endTime) {
+        NS_ASSERT_MSG(m_sim == nullptr, "The federate has already been started");
+        m_sim = DynamicCast<MosaicSimulatorImpl> (Simulator::GetImplementation());
+        if (m_sim == nullptr) {
+            NS_LOG_ERROR("Could not find Mosaic simulator implementation");
+            return false;
+        }
+        m_sim->AttachFederate(this);
+
+        auto setupStart = std::chrono::steady_clock::now();
+        if (m_config.commType == CommunicationType::DSRC) {
+            m_nodeManager->InitDsrc();
+        } else if (m_config.commType == CommunicationType::LTE) {
+            m_nodeManager->InitLte(m_config.numOfNodes, m_config.lteTopology, m_config.sidelink);
+        } else if (m_config.commType == CommunicationType::ANALYTICAL) {
+            m_nodeManager->InitAnalytical();
+        } else {
+            NS_LOG_ERROR("Unknown communication type:" << m_config.commType);
+            return false;
+        }
+        m_started = true;
+        std::chrono::duration<double, std::milli> setupTime = std::chrono::steady_clock::now() - setupStart;
+        // MosaicLogger keeps INFO in optimized builds, which remove NS_LOG, so setups can be compared where they are timed
+        MOSAIC_LOG_INFO("Setup took {} ms, {} events scheduled, max RSS {} MB", setupTime.count(), m_sim->GetEventCount(), GetMaxRssMb());
+
+        //create the dummy event (end of the simulation) to avoid a empty event-list
+        //NS3 will throw an exception if the event-list is empty
+        Simulator::Schedule(GetDelay(endTime), &MosaicFederate::Finish, this);
+        return true;
+    }
+
+    bool MosaicFederate::IsFinished(void) const {
+        return m_finished;
+    }
+
+    void MosaicFederate::AddNode(uint64_t time, uint32_t nodeId, const Vector &position, bool isRsu) {
+        m_sim->Schedule(GetDelay(time), MakeEvent(&MosaicNodeManager::CreateMosaicNode, m_nodeManager, nodeId, position, isRsu));
+    }
+
+    void MosaicFederate::MoveNode(uint64_t time, uint32_t nodeId, const Vector &position) {
+        m_sim->Schedule(GetDelay(time), MakeEvent(&MosaicNodeManager::UpdateNodePosition, m_nodeManager, nodeId, position));
+    }
+
+    void MosaicFederate::RemoveNode(uint64_t time, uint32_t nodeId) {
+        m_sim->Schedule(GetDelay(time), MakeEvent(&MosaicNodeManager::DeactivateNode, m_nodeManager, nodeId));
+    }
+
+    void MosaicFederate::ConfigureRadio(uint64_t time, uint32_t nodeId, bool radioTurnedOn, int transmitPower, uint32_t msgID) {
+        m_sim->Schedule(GetDelay(time), MakeEvent(&MosaicNodeManager::ConfigureNodeRadio, m_nodeManager, nodeId, radioTurnedOn, transmitPower, msgID));
+    }
+
+    void MosaicFederate::ConfigureSidelink(uint64_t time, const SidelinkUpdate &update) {
+        if (m_config.commType != CommunicationType::LTE) {
+            NS_LOG_WARN("Ignoring sidelink configuration, the federate does not simulate LTE");
+            return;
+        }
+        m_sim->Schedule(GetDelay(time), MakeEvent(&MosaicNodeManager::UpdateSidelink, m_nodeManager, update));
+    }
+
+    void MosaicFederate::Send(uint64_t time, uint32_t nodeId, uint32_t msgID, uint32_t payLength, Ipv4Address destination) {
+        m_sim->Schedule(GetDelay(time), MakeEvent(&MosaicNodeManager::SendMsg, m_nodeManager, nodeId, 0, msgID, payLength, destination));
+    }
+
+    void MosaicFederate::SendBatch(uint64_t time, std::vector<MosaicSendRequest> batch) {
+        m_sim->Schedule(GetDelay(time), MakeEvent(&MosaicNodeManager::SendMsgBatch, m_nodeManager, std::move(batch)));
+    }
+
+    uint64_t MosaicFederate::AdvanceTime(uint64_t time) {
+        //run the simulation while the time of the next event is not after the requested time
+        while (!Simulator::IsFinished() && NanoSeconds(time) >= m_sim->Next()) {
+            m_sim->RunOneEvent();
+        }
+        return Now();
+    }
+
+    uint64_t MosaicFederate::Now(void) const {
+        return Simulator::Now().GetNanoSeconds();
+    }
+
+    int64_t MosaicFederate::GetLookahead(uint64_t time) const {
+        if (!m_started) {
+            return -1;
+        }
+        return m_nodeManager->GetLookahead(NanoSeconds(time)).GetNanoSeconds();
+    }
+
+    CommunicationType MosaicFederate::GetCommType(void) const {
+        return m_config.commType;
+    }
+
+    Ptr<MosaicNodeManager> MosaicFederate::GetNodeManager(void) const {
+        return m_nodeManager;
+    }
+
+    void MosaicFederate::NotifyNextEvent(uint64_t time) {
+        if (m_nextEventCallback) {
+            m_nextEventCallback(time);
+        }
+    }
+
+    void MosaicFederate::NotifyReceive(uint64_t time, uint32_t nodeId, int msgID) {
+        if (m_receiveCallback) {
+            m_receiveCallback(time, nodeId, msgID);
+        }
+    }
+
+    void MosaicFederate::NotifyCommandError(uint32_t msgID) {
+        if (m_commandErrorCallback) {
+            m_commandErrorCallback(msgID);
+        }
+    }
+
+    Time MosaicFederate::GetDelay(uint64_t time) const {
+        return NanoSeconds(time) - m_sim->Now();
+    }
+
+    void MosaicFederate::Finish(void) {
+        MOSAIC_LOG_INFO("Finished at {} s, {} events scheduled, max RSS {} MB", Simulator::Now().GetSeconds(), m_sim->GetEventCount(),
+                GetMaxRssMb());
+        m_finished = true;
+    }
+}
@@ -0,0 +1,168 @@
+/*
+ * Copyright (c) 2020 Fraunhofer FOKUS and others. All rights reserved.
+ *
+ * Contact: mosaic@fokus.fraunhofer.de
+ *
+ * This class is developed for the MOSAIC-NS-3 coupling.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+
+#ifndef MOSAIC_FEDERATE_H
+#define MOSAIC_FEDERATE_H
+
+#include <functional>
+#include <vector>
+
+#include "ClientServerChannel.h"
+#include "mosaic-node-manager.h"
+#include "ns3/ipv4-address.h"
+#include "ns3/vector.h"
+
+namespace ns3 {
+    using namespace ClientServerChannelSpace;
+
+    class MosaicSimulatorImpl;
+
+    /**
+     * @class MosaicFederate
+     * @brief The in-process federate: node manager and MosaicSimulatorImpl behind
+     * direct calls, without any socket. MosaicNs3Server is the adapter which maps
+     * the MOSAIC coupling protocol onto this class, other programs can embed it
+     * directly or through the C API in mosaic-federate-c.h.
+     *
+     * All times are absolute simulation times in nanoseconds. Commands are
+     * scheduled at their time and executed by the next AdvanceTime call reaching it.
+     * The ns-3 simulator is a process wide singleton, hence there is at most one
+     * federate per process.
+     */
+    class MosaicFederate {
+    public:
+        /** @brief called whenever an event is scheduled, with its time */
+        typedef std::function<void(uint64_t time)> NextEventCallback;
+        /** @brief called when a node received a message, msgID is -1 for packets without message id */
+        typedef std::function<void(uint64_t time, uint32_t nodeId, int msgID)> ReceiveCallback;
+        /** @brief called when a send or radio configuration command could not be executed */
+        typedef std::function<void(uint32_t msgID)> CommandErrorCallback;
+
+        explicit MosaicFederate(const FederateConfig &config);
+        ~MosaicFederate();
+
+        MosaicFederate(const MosaicFederate &) = delete;
+        MosaicFederate &operator=(const MosaicFederate &) = delete;
+
+        void SetNextEventCallback(NextEventCallback callback);
+        void SetReceiveCallback(ReceiveCallback callback);
+        void SetCommandErrorCallback(CommandErrorCallback callback);
+
+        /**
+         * @brief attach to the simulator, set up the network and schedule the end of the simulation
+         *
+         * The simulator implementation must be ns3::MosaicSimulatorImpl, see the
+         * SimulatorImplementationType global value.
+         *
+         * @param endTime end of the simulation
+         * @return false, if the simulator implementation is not MosaicSimulatorImpl
+         */
+        bool Start(uint64_t endTime);
+
+        /**
+         * @brief true once the end of the simulation has been reached
+         */
+        bool IsFinished(void) const;
+
+        void AddNode(uint64_t time, uint32_t nodeId, const Vector &position, bool isRsu);
+        void MoveNode(uint64_t time, uint32_t nodeId, const Vector &position);
+
+        /**
+         * @brief deactivate a node, ns-3 nodes can not be deleted during the simulation
+         */
+        void RemoveNode(uint64_t time, uint32_t nodeId);
+
+        /**
+         * @brief configure a nodes radio
+         *
+         * @param transmitPower tx power in dBm, -1 keeps the configured power
+         * @param msgID reported to the command error callback if the node is unknown
+         */
+        void ConfigureRadio(uint64_t time, uint32_t nodeId, bool radioTurnedOn, int transmitPower, uint32_t msgID);
+
+        /**
+         * @brief change the sidelink configuration of all UEs, only for LTE
+         */
+        void ConfigureSidelink(uint64_t time, const SidelinkUpdate &update);
+
+        void Send(uint64_t time, uint32_t nodeId, uint32_t msgID, uint32_t payLength, Ipv4Address destination);
+
+        /**
+         * @brief send all messages of the batch with a single event at the given time
+         */
+        void SendBatch(uint64_t time, std::vector<MosaicSendRequest> batch);
+
+        /**
+         * @brief run all events up to and including the given time
+         *
+         * @return the simulation time reached
+         */
+        uint64_t AdvanceTime(uint64_t time);
+
+        uint64_t Now(void) const;
+
+        /**
+         * @brief the federate reports no reception before time plus the lookahead
+         *
+         * @param time the time of the next event or the time reached by AdvanceTime
+         * @return the lookahead in ns, -1 before Start
+         */
+        int64_t GetLookahead(uint64_t time) const;
+
+        CommunicationType GetCommType(void) const;
+
+        Ptr<MosaicNodeManager> GetNodeManager(void) const;
+
+        /**
+         * @brief called by MosaicSimulatorImpl for every scheduled event
+         */
+        void NotifyNextEvent(uint64_t time);
+
+        /**
+         * @brief called by the node manager for every message received by a MOSAIC node
+         */
+        void NotifyReceive(uint64_t time, uint32_t nodeId, int msgID);
+
+        /**
+         * @brief called by the node manager for commands it could not execute
+         */
+        void NotifyCommandError(uint32_t msgID);
+
+    private:
+        Time GetDelay(uint64_t time) const;
+
+        void Finish(void);
+
+        FederateConfig m_config;
+        Ptr<MosaicNodeManager> m_nodeManager;
+        // set by Start, keeps the implementation alive past Simulator::Destroy for the detach
+        Ptr<MosaicSimulatorImpl> m_sim;
+        bool m_started = false;
+        bool m_finished = false;
+
+        NextEventCallback m_nextEventCallback;
+        ReceiveCallback m_receiveCallback;
+        CommandErrorCallback m_commandErrorCallback;
+    };
+}
+#endif
@@ -0,0 +1,305 @@
+/*
+ * Copyright (c) 2020 Fraunhofer FOKUS and others. All rights reserved.
+ *
+ * Contact: mosaic@fokus.fraunhofer.de
+ *
+ * This class is developed for the MOSAIC-NS-3 coupling.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+
+#include "mosaic-logger.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstring>
+
+namespace ns3 {
+
+    std::atomic<int> g_mosaicLogLevel(MOSAIC_LOG_LEVEL_OFF);
+
+    static uint64_t NowNanoSeconds(void) {
+        return std::chrono::duration_cast<std::chrono::nanoseconds> (std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    static const char *LevelName(int level) {
+        switch (level) {
+            case MOSAIC_LOG_LEVEL_ERROR: return "ERROR";
+            case MOSAIC_LOG_LEVEL_WARN: return "WARN";
+            case MOSAIC_LOG_LEVEL_INFO: return "INFO";
+            case MOSAIC_LOG_LEVEL_DEBUG: return "DEBUG";
+            default: return "";
+        }
+    }
+
+    // std::min binds the constants to references, hence they need a definition before C++17
+    const std::size_t MosaicLogger::MAX_ARGS;
+    const std::size_t MosaicLogger::TEXT_SIZE;
+    const std::size_t MosaicLogger::CAPACITY;
+
+    MosaicLogger &MosaicLogger::Get(void) {
+        static MosaicLogger logger;
+        return logger;
+    }
+
+    MosaicLogger::MosaicLogger() : m_slots(new Slot[CAPACITY]), m_enqueuePos(0), m_dropped(0), m_pushed(0), m_printed(0), m_start(NowNanoSeconds()) {
+        for (std::size_t i = 0; i < CAPACITY; i++) {
+            m_slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MosaicLogger::~MosaicLogger() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_shutdown = true;
+        }
+        m_wakeUp.notify_all();
+        if (m_drainThread.joinable()) {
+            m_drainThread.join();
+        }
+    }
+
+    void MosaicLogger::SetLevel(int level) {
+        if (level > MOSAIC_LOG_LEVEL_OFF) {
+            Get().Start();
+        }
+        g_mosaicLogLevel.store(level, std::memory_order_relaxed);
+    }
+
+    int MosaicLogger::ParseLevel(const std::string &name) {
+        // accepts the ns-3 syntax, e.g. "debug|prefix_time" or "level_info", the most verbose level wins
+        int level = MOSAIC_LOG_LEVEL_OFF;
+        std::string::size_type begin = 0;
+        while (begin <= name.size()) {
+            std::string::size_type end = name.find('|', begin);
+            if (end == std::string::npos) {
+                end = name.size();
+            }
+            std::string token = name.substr(begin, end - begin);
+            if (token.compare(0, 6, "level_") == 0) {
+                token = token.substr(6);
+            }
+            if (token == "error") {
+                level = std::max(level, MOSAIC_LOG_LEVEL_ERROR);
+            } else if (token == "warn") {
+                level = std::max(level, MOSAIC_LOG_LEVEL_WARN);
+            } else if (token == "info") {
+                level = std::max(level, MOSAIC_LOG_LEVEL_INFO);
+            } else if (token == "debug" || token == "function" || token == "logic" || token == "all" || token == "*") {
+                level = MOSAIC_LOG_LEVEL_DEBUG;
+            }
+            begin = end + 1;
+        }
+        return level;
+    }
+
+    void MosaicLogger::Start(void) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_drainThread.joinable()) {
+            m_drainThread = std::thread(&MosaicLogger::DrainLoop, this);
+        }
+    }
+
+    void MosaicLogger::EncodeOther(Record &record, double value) {
+        record.types[record.numArgs] = ARG_DOUBLE;
+        record.args[record.numArgs++].d = value;
+    }
+
+    void MosaicLogger::EncodeOther(Record &record, const char *literal) {
+        record.types[record.numArgs] = ARG_LITERAL;
+        record.args[record.numArgs++].literal = literal;
+    }
+
+    void MosaicLogger::EncodeOther(Record &record, const std::string &text) {
+        if (record.textSize >= TEXT_SIZE - 1) {
+            // no room left for more than the terminator, keep the argument in place
+            EncodeOther(record, "");
+            return;
+        }
+        // the copy is clamped so the terminator always fits
+        const std::size_t size = std::min<std::size_t>(text.size(), TEXT_SIZE - 1 - record.textSize);
+        record.types[record.numArgs] = ARG_TEXT;
+        record.args[record.numArgs++].text = record.textSize;
+        std::memcpy(record.text + record.textSize, text.data(), size);
+        record.textSize += size;
+        record.text[record.textSize++] = '\0';
+    }
+
+    void MosaicLogger::WriteText(int level, const char *text, std::size_t size) {
+        Record record;
+        record.level = level;
+        record.format = nullptr;
+        record.numArgs = 0;
+        record.textSize = std::min(size, TEXT_SIZE);
+        std::memcpy(record.text, text, record.textSize);
+        Push(record);
+    }
+
+    void MosaicLogger::Push(const Record &record) {
+        // bounded MPMC queue, every slot carries the position it is free for
+        std::size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+        Slot *slot;
+        while (true) {
+            slot = &m_slots[pos % CAPACITY];
+            const std::size_t sequence = slot->sequence.load(std::memory_order_acquire);
+            const intptr_t difference = static_cast<intptr_t> (sequence) - static_cast<intptr_t> (pos);
+            if (difference == 0) {
+                if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (difference < 0) {
+                m_dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            } else {
+                pos = m_enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+        slot->record = record;
+        slot->record.timestamp = NowNanoSeconds();
+        slot->sequence.store(pos + 1, std::memory_order_release);
+        m_pushed.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    bool MosaicLogger::Pop(Record &record) {
+        Slot &slot = m_slots[m_dequeuePos % CAPACITY];
+        if (slot.sequence.load(std::memory_order_acquire) != m_dequeuePos + 1) {
+            return false;
+        }
+        record = slot.record;
+        slot.sequence.store(m_dequeuePos + CAPACITY, std::memory_order_release);
+        m_dequeuePos++;
+        return true;
+    }
+
+    void MosaicLogger::Flush(void) {
+        const uint64_t pushed = m_pushed.load(std::memory_order_relaxed);
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (!m_drainThread.joinable()) {
+            return;
+        }
+        m_wakeUp.notify_all();
+        m_drained.wait(lock, [this, pushed] { return m_printed.load(std::memory_order_relaxed) >= pushed || m_shutdown; });
+    }
+
+    void MosaicLogger::DrainLoop(void) {
+        Record record;
+        std::string line;
+        uint64_t reportedDrops = 0;
+        while (true) {
+            bool printed = false;
+            while (Pop(record)) {
+                Print(record, line);
+                std::fwrite(line.data(), 1, line.size(), stderr);
+                m_printed.fetch_add(1, std::memory_order_relaxed);
+                printed = true;
+            }
+            const uint64_t dropped = m_dropped.load(std::memory_order_relaxed);
+            if (dropped != reportedDrops) {
+                std::fprintf(stderr, "MosaicLogger: dropped %" PRIu64 " records, the ring was full\n", dropped - reportedDrops);
+                reportedDrops = dropped;
+            }
+            if (printed) {
+                std::fflush(stderr);
+            }
+
+            // producers do not signal, the ring is polled to keep the hot paths free of syscalls
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_drained.notify_all();
+            if (m_shutdown) {
+                lock.unlock();
+                while (Pop(record)) {
+                    Print(record, line);
+                    std::fwrite(line.data(), 1, line.size(), stderr);
+                }
+                std::fflush(stderr);
+                return;
+            }
+            m_wakeUp.wait_for(lock, std::chrono::milliseconds(10));
+        }
+    }
+
+    void MosaicLogger::Print(const Record &record, std::string &line) const {
+        char number[32];
+        std::snprintf(number, sizeof (number), "+%.6fs ", (record.timestamp - m_start) / 1e9);
+        line.assign(number);
+        line.append("[").append(LevelName(record.level)).append("] ");
+        if (record.format == nullptr) {
+            line.append(record.text, record.textSize);
+            while (!line.empty() && line.back() == '\n') {
+                line.pop_back();
+            }
+            line.push_back('\n');
+            return;
+        }
+        std::size_t arg = 0;
+        for (const char *c = record.format; *c != '\0'; c++) {
+            if (c[0] != '{' || c[1] != '}' || arg >= record.numArgs) {
+                line.push_back(*c);
+                continue;
+            }
+            switch (record.types[arg]) {
+                case ARG_INT:
+                    std::snprintf(number, sizeof (number), "%" PRId64, record.args[arg].i);
+                    line.append(number);
+                    break;
+                case ARG_UINT:
+                    std::snprintf(number, sizeof (number), "%" PRIu64, record.args[arg].u);
+                    line.append(number);
+                    break;
+                case ARG_DOUBLE:
+                    std::snprintf(number, sizeof (number), "%g", record.args[arg].d);
+                    line.append(number);
+                    break;
+                case ARG_LITERAL:
+                    line.append(record.args[arg].literal != nullptr ? record.args[arg].literal : "(null)");
+                    break;
+                case ARG_TEXT:
+                    line.append(record.text + record.args[arg].text);
+                    break;
+            }
+            arg++;
+            c++;
+        }
+        line.push_back('\n');
+    }
+
+    MosaicLogStream::Buffer::Buffer() {
+        setp(m_data, m_data + sizeof (m_data));
+    }
+
+    std::size_t MosaicLogStream::Buffer::Size(void) const {
+        return pptr() - pbase();
+    }
+
+    const char *MosaicLogStream::Buffer::Data(void) const {
+        return pbase();
+    }
+
+    MosaicLogStream::Buffer::int_type MosaicLogStream::Buffer::overflow(int_type c) {
+        // the record is full, the rest of the statement is truncated
+        return traits_type::not_eof(c);
+    }
+
+    MosaicLogStream::MosaicLogStream(int level) : m_level(level), m_stream(&m_buffer) {
+    }
+
+    MosaicLogStream::~MosaicLogStream() {
+        if (m_buffer.Size() > 0) {
+            MosaicLogger::Get().WriteText(m_level, m_buffer.Data(), m_buffer.Size());
+        }
+    }
+}
@@ -0,0 +1,275 @@
+/*
+ * Copyright (c) 2020 Fraunhofer FOKUS and others. All rights reserved.
+ *
+ * Contact: mosaic@fokus.fraunhofer.de
+ *
+ * This class is developed for the MOSAIC-NS-3 coupling.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+
+#ifndef MOSAIC_LOGGER_H
+#define MOSAIC_LOGGER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <type_traits>
+
+#define MOSAIC_LOG_LEVEL_OFF 0
+#define MOSAIC_LOG_LEVEL_ERROR 1
+#define MOSAIC_LOG_LEVEL_WARN 2
+#define MOSAIC_LOG_LEVEL_INFO 3
+#define MOSAIC_LOG_LEVEL_DEBUG 4
+
+/**
+ * Statements above this level are removed by the preprocessor. Release builds keep
+ * INFO and below, pass -DMOSAIC_LOG_COMPILED_LEVEL=0 to remove every statement.
+ */
+#ifndef MOSAIC_LOG_COMPILED_LEVEL
+#ifdef NDEBUG
+#define MOSAIC_LOG_COMPILED_LEVEL MOSAIC_LOG_LEVEL_INFO
+#else
+#define MOSAIC_LOG_COMPILED_LEVEL MOSAIC_LOG_LEVEL_DEBUG
+#endif
+#endif
+
+#define MOSAIC_LOG_WRITE(level, ...) \
+    do { \
+        if (::ns3::MosaicLogger::IsEnabled(level)) { \
+            ::ns3::MosaicLogger::Get().Write(level, __VA_ARGS__); \
+        } \
+    } while (false)
+
+/**
+ * The format must be a string literal, every {} is replaced by the next argument.
+ * Arguments are numbers, bools, enums, string literals or std::string, the latter
+ * is copied and truncated to fit the record.
+ */
+#if MOSAIC_LOG_COMPILED_LEVEL >= MOSAIC_LOG_LEVEL_ERROR
+#define MOSAIC_LOG_ERROR(...) MOSAIC_LOG_WRITE(MOSAIC_LOG_LEVEL_ERROR, __VA_ARGS__)
+#else
+#define MOSAIC_LOG_ERROR(...) do {} while (false)
+#endif
+
+#if MOSAIC_LOG_COMPILED_LEVEL >= MOSAIC_LOG_LEVEL_WARN
+#define MOSAIC_LOG_WARN(...) MOSAIC_LOG_WRITE(MOSAIC_LOG_LEVEL_WARN, __VA_ARGS__)
+#else
+#define MOSAIC_LOG_WARN(...) do {} while (false)
+#endif
+
+#if MOSAIC_LOG_COMPILED_LEVEL >= MOSAIC_LOG_LEVEL_INFO
+#define MOSAIC_LOG_INFO(...) MOSAIC_LOG_WRITE(MOSAIC_LOG_LEVEL_INFO, __VA_ARGS__)
+#else
+#define MOSAIC_LOG_INFO(...) do {} while (false)
+#endif
+
+#if MOSAIC_LOG_COMPILED_LEVEL >= MOSAIC_LOG_LEVEL_DEBUG
+#define MOSAIC_LOG_DEBUG(...) MOSAIC_LOG_WRITE(MOSAIC_LOG_LEVEL_DEBUG, __VA_ARGS__)
+#else
+#define MOSAIC_LOG_DEBUG(...) do {} while (false)
+#endif
+
+namespace ns3 {
+
+    // runtime level, read on every statement which survived the preprocessor
+    extern std::atomic<int> g_mosaicLogLevel;
+
+    /**
+     * @class MosaicLogger
+     * @brief Asynchronous logger for the hot paths of the federate. A statement copies
+     * its format pointer and raw arguments into a fixed size record of a bounded
+     * lock-free ring, a background thread formats the records and writes them to
+     * stderr. Producers never block or allocate, records are dropped if the ring is
+     * full and the number of dropped records is reported.
+     */
+    class MosaicLogger {
+    public:
+        static const std::size_t MAX_ARGS = 8;
+        static const std::size_t TEXT_SIZE = 160;
+        static const std::size_t CAPACITY = 4096;
+
+        static MosaicLogger &Get(void);
+
+        static bool IsEnabled(int level) {
+            return level <= g_mosaicLogLevel.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief set the runtime level, the drain thread is started with the first level above OFF
+         */
+        static void SetLevel(int level);
+
+        /**
+         * @return the level of a name like "debug" or "level_warn|prefix_time", OFF for unknown names
+         */
+        static int ParseLevel(const std::string &name);
+
+        template <typename... Args>
+        void Write(int level, const char *format, const Args &... args) {
+            static_assert(sizeof... (Args) <= MAX_ARGS, "too many log arguments");
+            Record record;
+            record.level = level;
+            record.format = format;
+            record.numArgs = 0;
+            record.textSize = 0;
+            Encode(record, args...);
+            Push(record);
+        }
+
+        /**
+         * @brief log preformatted text, used by MosaicLogStream
+         */
+        void WriteText(int level, const char *text, std::size_t size);
+
+        /**
+         * @brief block until all records written so far are printed
+         */
+        void Flush(void);
+
+        ~MosaicLogger();
+
+    private:
+        enum ArgType : uint8_t {
+            ARG_INT, ARG_UINT, ARG_DOUBLE, ARG_LITERAL, ARG_TEXT
+        };
+
+        union Arg {
+            int64_t i;
+            uint64_t u;
+            double d;
+            const char *literal;
+            // offset of the copied string in the text buffer
+            uint32_t text;
+        };
+
+        struct Record {
+            uint64_t timestamp;
+            const char *format;
+            int level;
+            uint8_t numArgs;
+            uint8_t types[MAX_ARGS];
+            Arg args[MAX_ARGS];
+            uint32_t textSize;
+            char text[TEXT_SIZE];
+        };
+
+        struct Slot {
+            std::atomic<std::size_t> sequence;
+            Record record;
+        };
+
+        MosaicLogger();
+
+        void Encode(Record &) {
+        }
+
+        template <typename T, typename... Rest>
+        void Encode(Record &record, const T &value, const Rest &... rest) {
+            EncodeArg(record, value, std::integral_constant<bool, std::is_enum<T>::value || std::is_integral<T>::value>(), std::is_signed<T>());
+            Encode(record, rest...);
+        }
+
+        template <typename T>
+        void EncodeArg(Record &record, const T &value, std::true_type /* integral */, std::true_type /* signed */) {
+            record.types[record.numArgs] = ARG_INT;
+            record.args[record.numArgs++].i = static_cast<int64_t> (value);
+        }
+
+        template <typename T>
+        void EncodeArg(Record &record, const T &value, std::true_type /* integral */, std::false_type /* signed */) {
+            if (std::is_same<T, bool>::value || std::is_enum<T>::value) {
+                record.types[record.numArgs] = ARG_INT;
+                record.args[record.numArgs++].i = static_cast<int64_t> (value);
+                return;
+            }
+            record.types[record.numArgs] = ARG_UINT;
+            record.args[record.numArgs++].u = static_cast<uint64_t> (value);
+        }
+
+        template <typename T, typename Signed>
+        void EncodeArg(Record &record, const T &value, std::false_type /* integral */, Signed) {
+            EncodeOther(record, value);
+        }
+
+        void EncodeOther(Record &record, double value);
+        void EncodeOther(Record &record, const char *literal);
+        void EncodeOther(Record &record, const std::string &text);
+
+        void Push(const Record &record);
+        void Start(void);
+        void DrainLoop(void);
+        bool Pop(Record &record);
+        void Print(const Record &record, std::string &line) const;
+
+        std::unique_ptr<Slot[]> m_slots;
+        std::atomic<std::size_t> m_enqueuePos;
+        std::atomic<uint64_t> m_dropped;
+        std::atomic<uint64_t> m_pushed;
+        // only touched by the drain thread
+        std::size_t m_dequeuePos = 0;
+        std::atomic<uint64_t> m_printed;
+        uint64_t m_start;
+
+        std::mutex m_mutex;
+        std::condition_variable m_wakeUp;
+        std::condition_variable m_drained;
+        bool m_shutdown = false;
+        std::thread m_drainThread;
+    };
+
+    /**
+     * @class MosaicLogStream
+     * @brief ostream into a fixed buffer, committed to the logger as one record when it
+     * goes out of scope. Keeps statements in stream syntax asynchronous, e.g. the
+     * LOG_DEBUG statements of the ClientServerChannel.
+     */
+    class MosaicLogStream {
+    public:
+        explicit MosaicLogStream(int level);
+        ~MosaicLogStream();
+
+        std::ostream &Get(void) {
+            return m_stream;
+        }
+
+    private:
+        class Buffer : public std::streambuf {
+        public:
+            Buffer();
+            std::size_t Size(void) const;
+            const char *Data(void) const;
+
+        protected:
+            virtual int_type overflow(int_type c);
+
+        private:
+            char m_data[MosaicLogger::TEXT_SIZE];
+        };
+
+        int m_level;
+        Buffer m_buffer;
+        std::ostream m_stream;
+    };
+}
+#endif
@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2020 Fraunhofer FOKUS and others. All rights reserved.
+ *
+ * Contact: mosaic@fokus.fraunhofer.de
+ *
+ * This class is developed for the MOSAIC-NS-3 coupling.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+
+#include "mosaic-mobility-model.h"
+
+namespace ns3 {
+
+    NS_OBJECT_ENSURE_REGISTERED(MosaicMobilityModel);
+
+    TypeId MosaicMobilityModel::GetTypeId(void) {
+        static TypeId tid = TypeId("ns3::MosaicMobilityModel")
+                .SetParent<MobilityModel>()
+                .AddConstructor<MosaicMobilityModel>();
+        return tid;
+    }
+
+    void MosaicMobilityModel::SetVelocity(const Vector &velocity) {
+        m_helper.Update();
+        m_helper.SetVelocity(velocity);
+        m_helper.Unpause();
+        NotifyCourseChange();
+    }
+
+    void MosaicMobilityModel::SetPositionAndVelocity(const Vector &position, const Vector &velocity) {
+        m_helper.SetPosition(position);
+        m_helper.SetVelocity(velocity);
+        m_helper.Unpause();
+        NotifyCourseChange();
+    }
+
+    Vector MosaicMobilityModel::DoGetPosition(void) const {
+        m_helper.Update();
+        return m_helper.GetCurrentPosition();
+    }
+
+    void MosaicMobilityModel::DoSetPosition(const Vector &position) {
+        m_helper.SetPosition(position);
+        NotifyCourseChange();
+    }
+
+    Vector MosaicMobilityModel::DoGetVelocity(void) const {
+        return m_helper.GetVelocity();
+    }
+}
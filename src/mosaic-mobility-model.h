@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2020 Fraunhofer FOKUS and others. All rights reserved.
+ *
+ * Contact: mosaic@fokus.fraunhofer.de
+ *
+ * This class is developed for the MOSAIC-NS-3 coupling.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+
+#ifndef MOSAIC_MOBILITY_MODEL_H
+#define MOSAIC_MOBILITY_MODEL_H
+
+#include "ns3/constant-velocity-helper.h"
+#include "ns3/mobility-model.h"
+
+namespace ns3 {
+
+    /**
+     * @class MosaicMobilityModel
+     * @brief Constant velocity mobility of the MOSAIC nodes. Unlike the ConstantVelocityMobilityModel
+     * position and velocity can be replaced together, which fires a single course change
+     * instead of one per setter.
+     */
+    class MosaicMobilityModel : public MobilityModel {
+    public:
+        static TypeId GetTypeId(void);
+
+        MosaicMobilityModel() = default;
+        virtual ~MosaicMobilityModel() = default;
+
+        /**
+         * @brief keep the current position and move on with the given velocity
+         */
+        void SetVelocity(const Vector &velocity);
+
+        /**
+         * @brief continue from the given position with the given velocity, notifies one course change
+         */
+        void SetPositionAndVelocity(const Vector &position, const Vector &velocity);
+
+    private:
+        virtual Vector DoGetPosition(void) const;
+        virtual void DoSetPosition(const Vector &position);
+        virtual Vector DoGetVelocity(void) const;
+
+        ConstantVelocityHelper m_helper;
+    };
+}
+#endif
@@ -23,20 +23,34 @@
 #include "ns3/yans-wifi-phy.h"
 #include "mosaic-node-manager.h"
 
-#include "mosaic-ns3-server.h"
+#include "mosaic-federate.h"
+#include "mosaic-logger.h"
 #include "ns3/netanim-module.h"
 
 #include "ns3/wave-net-device.h"
 #include "mosaic-proxy-app.h"
+#include "mosaic-mobility-model.h"
 #include "ns3/string.h"
+#include "ns3/pointer.h"
 #include "ns3/internet-stack-helper.h"
 #include "ns3/log.h"
-#include "ns3/constant-velocity-mobility-model.h"
 #include "ns3/log.h"
 #include "ns3/wifi-net-device.h"
 #include "ns3/node-list.h"
 #include "ns3/mobility-module.h"
-#include "ns3/config-store.h"
+#include "ns3/boolean.h"
+#include "ns3/double.h"
+#include "ns3/uinteger.h"
+#include "ns3/simulator.h"
+#include "ns3/lte-ue-net-device.h"
+#include "ns3/lte-ue-rrc.h"
+#include "ns3/lte-enb-phy.h"
+#include "ns3/lte-spectrum-phy.h"
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <sstream>
 
 NS_LOG_COMPONENT_DEFINE("MosaicNodeManager");
 
@@ -55,41 +69,80 @@ namespace ns3 {
                 .AddAttribute("DelayModel", "The used delay model",
                 StringValue("ns3::ConstantSpeedPropagationDelayModel"),
                 MakeStringAccessor(&MosaicNodeManager::m_delayModel),
-                MakeStringChecker());
+                MakeStringChecker())
+                .AddAttribute("LteLossModel", "The path loss model of LTE, its loss is cached for the links of RSUs and eNodeBs "
+                "only if it is deterministic, which the shadowing of the default model is not",
+                StringValue("ns3::CniUrbanmicrocellPropagationLossModel"),
+                MakeStringAccessor(&MosaicNodeManager::m_lteLossModel),
+                MakeStringChecker())
+                .AddAttribute("PositionUpdateThreshold", "Position updates closer than this distance in meters to the "
+                "current position of the node are dropped, 0 only drops updates which do not move the node",
+                DoubleValue(0.0),
+                MakeDoubleAccessor(&MosaicNodeManager::m_positionUpdateThreshold),
+                MakeDoubleChecker<double>(0.0))
+                .AddAttribute("DeadReckoning", "Derive the velocity of a vehicle from its last two position updates, "
+                "so its position is extrapolated between updates",
+                BooleanValue(false),
+                MakeBooleanAccessor(&MosaicNodeManager::m_deadReckoning),
+                MakeBooleanChecker())
+                .AddAttribute("SidelinkGroups", "Number of sidelink groups shared by all UEs in LTE mode, "
+                "0 creates one group per UE",
+                UintegerValue(0),
+                MakeUintegerAccessor(&MosaicNodeManager::m_sidelinkGroups),
+                MakeUintegerChecker<uint32_t>())
+                .AddAttribute("UePoolGrowth", "Number of UEs added to the LTE UE pool at runtime when it is exhausted, "
+                "0 does not grow the pool",
+                UintegerValue(16),
+                MakeUintegerAccessor(&MosaicNodeManager::m_uePoolGrowth),
+                MakeUintegerChecker<uint32_t>())
+                .AddAttribute("SidelinkOnly", "Simulate LTE sidelink V2X only: no EPC, no eNodeBs and no attach of the UEs, "
+                "the UEs use the preconfigured sidelink pools as out of coverage",
+                BooleanValue(false),
+                MakeBooleanAccessor(&MosaicNodeManager::m_sidelinkOnly),
+                MakeBooleanChecker())
+                .AddAttribute("Lookahead", "Minimum delay between a send and the first reception, 0 derives it from the communication type. "
+                "The advertised lookahead is additionally bounded by the receptions in flight, except for LTE",
+                TimeValue(Seconds(0)),
+                MakeTimeAccessor(&MosaicNodeManager::m_lookahead),
+                MakeTimeChecker());
         return tid;
     }
 
-    MosaicNodeManager::MosaicNodeManager() : m_ipAddressHelper("10.1.0.0", "255.255.0.0") {
+    MosaicNodeManager::MosaicNodeManager() : m_positionUpdateThreshold(0.0), m_deadReckoning(false), m_sidelinkGroups(0), m_uePoolGrowth(16), m_sidelinkOnly(false), m_ipAddressHelper("10.1.0.0", "255.255.0.0"),
+    m_ueAddressHelper("7.0.0.0", "255.0.0.0", "0.0.0.2") {
+        m_traceTables.fill(-1);
     }
 
-    void MosaicNodeManager::Configure(MosaicNs3Server* serverPtr, CommunicationType commType) {
-        m_serverPtr = serverPtr;
-        m_commType = commType;
+    void MosaicNodeManager::DoDispose(void) {
+        // writes the buffered trace rows
+        m_traceWriter.reset();
+        m_traceTables.fill(-1);
+        if (m_analyticalChannel != nullptr) {
+            // drops the receive callback, messages still in flight are not reported
+            m_analyticalChannel->Dispose();
+        }
+        if (m_staticNodes != nullptr) {
+            m_staticNodes->Dispose();
+            m_staticNodes = nullptr;
+        }
+        Object::DoDispose();
     }
 
-    void MosaicNodeManager::InitLte(int numOfNode){
-        
-        ConfigStore inputConfig; 
-        inputConfig.ConfigureDefaults(); 
-
-        NodeContainer ueAllNodes;
-        m_ueNodes.Create(numOfNode);
-        ueAllNodes.Add(m_ueNodes);
+    void MosaicNodeManager::Configure(MosaicFederate* federate, const FederateConfig &config) {
+        m_federate = federate;
+        m_commType = config.commType;
+        m_traceConfig = config.traces;
+    }
 
-        MobilityHelper mobility;
-        mobility.SetMobilityModel("ns3::ConstantVelocityMobilityModel");
-        Ptr<ListPositionAllocator> positionAlloc = CreateObject<ListPositionAllocator>();
+    void MosaicNodeManager::InitLte(int numOfNode, const LteTopologyConfig &topology, const SidelinkConfig &sidelink){
 
-        // Set the distant position to (10000, 10000, 0) which is faraway from the scenario
-        positionAlloc->Add(Vector(10000, 10000, 0));
-        mobility.SetPositionAllocator(positionAlloc);
-        mobility.Install(m_ueNodes);
- 
-        Ptr<PointToPointEpcHelper> epcHelper = CreateObject<PointToPointEpcHelper>();
-        Ptr<Node> pgw = epcHelper->GetPgwNode();
+        NodeContainer ueAllNodes = CreateUeNodes(numOfNode);
 
         m_lteHelper = CreateObject<LteHelper>();
-        m_lteHelper->SetEpcHelper(epcHelper);
+        if (!m_sidelinkOnly) {
+            m_epcHelper = CreateObject<PointToPointEpcHelper>();
+            m_lteHelper->SetEpcHelper(m_epcHelper);
+        }
         m_lteHelper->DisableNewEnbPhy();
 
         m_lteV2xHelper = CreateObject<LteV2xHelper>();
@@ -98,137 +151,357 @@ namespace ns3 {
         m_lteHelper->SetEnbAntennaModelType ("ns3::NistParabolic3dAntennaModel");
         
         m_lteHelper->SetAttribute ("UseSameUlDlPropagationCondition", BooleanValue(true));
-        m_lteHelper->SetAttribute ("PathlossModel", StringValue ("ns3::CniUrbanmicrocellPropagationLossModel"));
+        // RSUs and the eNB do not move, the loss of their links is cached per cell of the other end
+        // if the wrapped model is deterministic
+        m_staticNodes = CreateObject<MosaicStaticNodeRegistry>();
+        m_lteHelper->SetAttribute ("PathlossModel", StringValue ("ns3::MosaicCachedPropagationLossModel"));
+        m_lteHelper->SetPathlossModelAttribute ("ModelType", StringValue (m_lteLossModel));
+        m_lteHelper->SetPathlossModelAttribute ("StaticNodes", PointerValue (m_staticNodes));
         
-        m_eNodeB.Create(1); 
+        if (m_sidelinkOnly) {
+            NS_LOG_INFO("Sidelink only, no EPC and no eNodeBs are created");
+        } else {
+            InstallEnbs(topology);
+        }
+        SetupTraces();
 
+        m_lteHelper->SetAttribute("UseSidelink", BooleanValue (true));
+
+        // Sidelink configuration
+        m_ueSidelinkConfiguration = CreateObject<LteUeRrcSl>();
+        m_ueSidelinkConfiguration->SetSlEnabled(true);
+        m_ueSidelinkConfiguration->SetV2xEnabled(true);
+
+        m_sidelinkConfig = sidelink;
+        const SidelinkPreset *preset = GetSidelinkPreset(m_sidelinkConfig.preset);
+        if (preset == nullptr) {
+            NS_LOG_ERROR("Unknown sidelink preset " << m_sidelinkConfig.preset << ", using the default preset");
+            preset = GetSidelinkPreset("default");
+        }
+        m_activeSidelinkPreset = *preset;
+        LteRrcSap::SlV2xPreconfiguration preconfiguration = CreateSidelinkPreconfiguration(m_activeSidelinkPreset);
+        m_ueSidelinkConfiguration->SetSlV2xPreconfiguration (preconfiguration); 
+
+        Ipv4AddressGenerator::Init(Ipv4Address ("225.0.0.0"), Ipv4Mask("255.0.0.0"));
+        InstallUes(ueAllNodes);
+    }
+
+    void MosaicNodeManager::InstallEnbs(const LteTopologyConfig &topology){
         // Topology eNodeB
+        std::vector<Vector> sites = topology.sites;
+        if (sites.empty()) {
+            sites.push_back(Vector(5,-10,30));
+        }
+        m_eNodeB.Create(sites.size());
         Ptr<ListPositionAllocator> pos_eNB = CreateObject<ListPositionAllocator>(); 
-        pos_eNB->Add(Vector(5,-10,30));
+        for (const Vector &site : sites) {
+            pos_eNB->Add(site);
+        }
 
         // Install mobility eNodeB
         MobilityHelper mob_eNB;
         mob_eNB.SetMobilityModel("ns3::ConstantPositionMobilityModel");
         mob_eNB.SetPositionAllocator(pos_eNB);
         mob_eNB.Install(m_eNodeB);
-        
-        NetDeviceContainer enbDev = m_lteHelper->InstallEnbDevice(m_eNodeB);
+        for (uint32_t i = 0; i < m_eNodeB.GetN(); i++) {
+            m_staticNodes->Register(m_eNodeB.Get(i)->GetObject<MobilityModel>());
+        }
+
+        m_handover = topology.handover && m_eNodeB.GetN() > 1;
+        if (m_handover) {
+            m_lteHelper->SetHandoverAlgorithmType("ns3::A3RsrpHandoverAlgorithm");
+        }
+        m_enbDev = m_lteHelper->InstallEnbDevice(m_eNodeB);
+        if (m_handover) {
+            m_lteHelper->AddX2Interface(m_eNodeB);
+        }
+        NS_LOG_INFO("Created " << m_eNodeB.GetN() << " eNodeBs, handover " << (m_handover ? "enabled" : "disabled"));
 
         BuildingsHelper::Install (m_eNodeB);
+    }
+
+    void MosaicNodeManager::SetupTraces(){
+        if (m_traceConfig.sources.empty()) {
+            return;
+        }
+        m_traceWriter.reset(new MosaicTraceWriter(m_traceConfig.file, m_traceConfig.blockRows, m_traceConfig.flushInterval));
+        if (!m_traceWriter->IsOpen()) {
+            NS_LOG_ERROR("Could not open trace file " << m_traceConfig.file << ", tracing is disabled");
+            m_traceWriter.reset();
+            return;
+        }
+
+        static const char *names[TRACE_SOURCES] = {"Send", "Receive", "DlTxPhy", "UlTxPhy", "DlRxPhy", "UlRxPhy", "RsrpSinr"};
+        const std::vector<MosaicTraceWriter::Column> message = {{"time", MosaicTraceWriter::INT64},
+            {"nodeId", MosaicTraceWriter::UINT32}, {"msgId", MosaicTraceWriter::UINT32}};
+        std::vector<MosaicTraceWriter::Column> transmission = {{"time", MosaicTraceWriter::INT64},
+            {"cellId", MosaicTraceWriter::UINT16}, {"imsi", MosaicTraceWriter::UINT64}, {"rnti", MosaicTraceWriter::UINT16},
+            {"txMode", MosaicTraceWriter::UINT8}, {"layer", MosaicTraceWriter::UINT8}, {"mcs", MosaicTraceWriter::UINT8},
+            {"size", MosaicTraceWriter::UINT16}, {"rv", MosaicTraceWriter::UINT8}, {"ndi", MosaicTraceWriter::UINT8}};
+        std::vector<MosaicTraceWriter::Column> reception = transmission;
+        reception.push_back({"correctness", MosaicTraceWriter::UINT8});
+        const std::vector<MosaicTraceWriter::Column> rsrpSinr = {{"time", MosaicTraceWriter::INT64},
+            {"cellId", MosaicTraceWriter::UINT16}, {"rnti", MosaicTraceWriter::UINT16},
+            {"rsrp", MosaicTraceWriter::DOUBLE}, {"sinr", MosaicTraceWriter::DOUBLE}};
+        const std::vector<MosaicTraceWriter::Column> *columns[TRACE_SOURCES] = {&message, &message,
+            &transmission, &transmission, &reception, &reception, &rsrpSinr};
+
+        for (const std::string &source : m_traceConfig.sources) {
+            int index = std::find(names, names + TRACE_SOURCES, source) - names;
+            if (index == TRACE_SOURCES) {
+                NS_LOG_ERROR("Unknown trace source " << source);
+            } else if (index > TRACE_RECEIVE && m_commType != LTE) {
+                NS_LOG_WARN("Trace source " << source << " is only available in LTE mode");
+            } else if (m_traceTables[index] < 0) {
+                m_traceTables[index] = m_traceWriter->AddTable(source, *columns[index]);
+            }
+        }
+
+        for (uint32_t i = 0; i < m_enbDev.GetN(); i++) {
+            Ptr<LteEnbPhy> phy = DynamicCast<LteEnbNetDevice> (m_enbDev.Get(i))->GetPhy();
+            if (IsTraced(TRACE_DL_TX_PHY)) {
+                phy->TraceConnectWithoutContext("DlPhyTransmission", MakeCallback(&MosaicNodeManager::TraceDlTxPhy, this));
+            }
+            if (IsTraced(TRACE_UL_RX_PHY)) {
+                phy->GetUlSpectrumPhy()->TraceConnectWithoutContext("UlPhyReception", MakeCallback(&MosaicNodeManager::TraceUlRxPhy, this));
+            }
+        }
+        // UEs are connected when they are installed, see InstallUes
+    }
+
+    void MosaicNodeManager::ConnectUeTraces(NetDeviceContainer ueDevs){
+        if (m_traceWriter == nullptr) {
+            return;
+        }
+        for (uint32_t i = 0; i < ueDevs.GetN(); i++) {
+            Ptr<LteUePhy> phy = DynamicCast<LteUeNetDevice> (ueDevs.Get(i))->GetPhy();
+            if (IsTraced(TRACE_UL_TX_PHY)) {
+                phy->TraceConnectWithoutContext("UlPhyTransmission", MakeCallback(&MosaicNodeManager::TraceUlTxPhy, this));
+            }
+            if (IsTraced(TRACE_DL_RX_PHY)) {
+                phy->GetDlSpectrumPhy()->TraceConnectWithoutContext("DlPhyReception", MakeCallback(&MosaicNodeManager::TraceDlRxPhy, this));
+            }
+            if (IsTraced(TRACE_RSRP_SINR)) {
+                phy->TraceConnectWithoutContext("ReportCurrentCellRsrpSinr", MakeCallback(&MosaicNodeManager::TraceRsrpSinr, this));
+            }
+        }
+    }
+
+    void MosaicNodeManager::TraceDlTxPhy(PhyTransmissionStatParameters params){
+        WritePhyTransmission(m_traceTables[TRACE_DL_TX_PHY], params);
+    }
+
+    void MosaicNodeManager::TraceUlTxPhy(PhyTransmissionStatParameters params){
+        WritePhyTransmission(m_traceTables[TRACE_UL_TX_PHY], params);
+    }
+
+    void MosaicNodeManager::TraceDlRxPhy(PhyReceptionStatParameters params){
+        WritePhyReception(m_traceTables[TRACE_DL_RX_PHY], params);
+    }
+
+    void MosaicNodeManager::TraceUlRxPhy(PhyReceptionStatParameters params){
+        WritePhyReception(m_traceTables[TRACE_UL_RX_PHY], params);
+    }
+
+    void MosaicNodeManager::TraceRsrpSinr(uint16_t cellId, uint16_t rnti, double rsrp, double sinr, uint8_t componentCarrierId){
+        if (!IsTraced(TRACE_RSRP_SINR)) {
+            return;
+        }
+        m_traceWriter->Append(m_traceTables[TRACE_RSRP_SINR], (int64_t) Simulator::Now().GetNanoSeconds(), cellId, rnti, rsrp, sinr);
+    }
+
+    void MosaicNodeManager::WritePhyTransmission(uint16_t table, const PhyTransmissionStatParameters &params){
+        if (m_traceWriter == nullptr) {
+            return;
+        }
+        m_traceWriter->Append(table, (int64_t) Simulator::Now().GetNanoSeconds(), (uint16_t) params.m_cellId,
+                (uint64_t) params.m_imsi, (uint16_t) params.m_rnti, (uint8_t) params.m_txMode, (uint8_t) params.m_layer,
+                (uint8_t) params.m_mcs, (uint16_t) params.m_size, (uint8_t) params.m_rv, (uint8_t) params.m_ndi);
+    }
+
+    void MosaicNodeManager::WritePhyReception(uint16_t table, const PhyReceptionStatParameters &params){
+        if (m_traceWriter == nullptr) {
+            return;
+        }
+        m_traceWriter->Append(table, (int64_t) Simulator::Now().GetNanoSeconds(), (uint16_t) params.m_cellId,
+                (uint64_t) params.m_imsi, (uint16_t) params.m_rnti, (uint8_t) params.m_txMode, (uint8_t) params.m_layer,
+                (uint8_t) params.m_mcs, (uint16_t) params.m_size, (uint8_t) params.m_rv, (uint8_t) params.m_ndi,
+                (uint8_t) params.m_correctness);
+    }
+
+    NodeContainer MosaicNodeManager::CreateUeNodes(uint32_t count){
+        NodeContainer ueNodes;
+        ueNodes.Create(count);
+        m_ueNodes.Add(ueNodes);
+
+        MobilityHelper mobility;
+        mobility.SetMobilityModel("ns3::MosaicMobilityModel");
+        Ptr<ListPositionAllocator> positionAlloc = CreateObject<ListPositionAllocator>();
+
+        // Set the distant position to (10000, 10000, 0) which is faraway from the scenario
+        positionAlloc->Add(Vector(10000, 10000, 0));
+        mobility.SetPositionAllocator(positionAlloc);
+        mobility.Install(ueNodes);
+        return ueNodes;
+    }
+
+    void MosaicNodeManager::InstallUes(NodeContainer ueAllNodes){
         BuildingsHelper::Install (ueAllNodes);
         BuildingsHelper::MakeMobilityModelConsistent();  
         
-        m_lteHelper->SetAttribute("UseSidelink", BooleanValue (true));
-        NetDeviceContainer ueRespondersDevs = m_lteHelper->InstallUeDevice (m_ueNodes);
+        NetDeviceContainer ueRespondersDevs = m_lteHelper->InstallUeDevice (ueAllNodes);
         
+        for (uint32_t i=0; i<ueRespondersDevs.GetN();i++)
+        {
+            m_ns3Id2DeviceId[ueRespondersDevs.Get(i)->GetNode()->GetId()] = m_ueDevs.GetN() + i;
+        }
         m_ueDevs.Add(ueRespondersDevs);
-        
-        for (uint16_t i=0; i<m_ueNodes.GetN();i++)
+        // the free list is used as a stack, the UE with the lowest id is taken first
+        for (uint32_t i = ueAllNodes.GetN(); i > 0; i--)
         {
-            m_ns3Id2DeviceId[m_ueNodes.Get(i)->GetId()] = i;
-            m_ueNodeIdList.push_back(m_ueNodes.Get(i)->GetId());
+            m_freeUes.push_back(ueAllNodes.Get(i - 1)->GetId());
         }
 
         // Install the IP stack on the UEs        
         InternetStackHelper internet;
         internet.Install (ueAllNodes); 
 
-        // Assign an IPv4 address to the LTE device
-        Ipv4InterfaceContainer vehicleIpIface = epcHelper->AssignUeIpv4Address(m_ueDevs);
+        // Assign an IPv4 address to the LTE device, from the same network as the EPC helper does without EPC
+        Ipv4Address gateway;
+        if (m_epcHelper != nullptr) {
+            m_epcHelper->AssignUeIpv4Address(ueRespondersDevs);
+            gateway = m_epcHelper->GetUeDefaultGatewayAddress();
+        } else {
+            m_ueAddressHelper.Assign(ueRespondersDevs);
+            // the sidelink multicast is routed to the LTE device, the gateway itself does not exist
+            gateway = Ipv4Address("7.0.0.1");
+        }
         Ipv4StaticRoutingHelper Ipv4RoutingHelper;
 
-        // Set up static routing for the node to use the default gateway provided by the EPC helper
+        // Set up static routing for the node to use the default gateway
         for(uint32_t i = 0; i < ueAllNodes.GetN(); ++i)
         {
             Ptr<Node> ueNode = ueAllNodes.Get(i);
             // Set the default gateway for the UE
             Ptr<Ipv4StaticRouting> ueStaticRouting = Ipv4RoutingHelper.GetStaticRouting(ueNode->GetObject<Ipv4>());
-            ueStaticRouting->SetDefaultRoute (epcHelper->GetUeDefaultGatewayAddress(), 1);       
+            ueStaticRouting->SetDefaultRoute (gateway, 1);       
         }
 
-        // // Attach the LTE device to the eNodeB (base station)
-        m_lteHelper->Attach(m_ueDevs);
-
-        std::vector<NetDeviceContainer> txGroups = m_lteV2xHelper->AssociateForV2xBroadcast(ueRespondersDevs, numOfNode); 
-
-        uint32_t groupL2Address = 0x00;
-        Ipv4AddressGenerator::Init(Ipv4Address ("225.0.0.0"), Ipv4Mask("255.0.0.0"));
-        Ipv4Address multicastAddress = Ipv4AddressGenerator::NextAddress (Ipv4Mask ("255.0.0.0"));
-
-        for(std::vector<NetDeviceContainer>::iterator gIt=txGroups.begin(); gIt != txGroups.end(); gIt++){
+        // The UEs of the pool are attached to their nearest eNodeB once a node takes them, see AttachToNearestEnb,
+        // in sidelink only mode they are never attached
 
-            Ptr<NetDevice> ueDev = gIt->Get(0);
-            Ptr<Node> ueNode = ueDev->GetNode();
+        if (m_sidelinkGroups > 0) {
+            // Shared groups: every UE transmits on one of the groups and receives all of them,
+            // so the number of bearers grows with UEs * groups instead of UEs * UEs
+            while (m_sidelinkGroupAddresses.size() < m_sidelinkGroups) {
+                m_sidelinkGroupAddresses.push_back(SidelinkGroup{Ipv4AddressGenerator::NextAddress (Ipv4Mask ("255.0.0.0")),
+                        (uint32_t) m_sidelinkGroupAddresses.size(), nullptr});
+            }
+            for (const SidelinkGroup &group : m_sidelinkGroupAddresses) {
+                Ptr<LteSlTft> rxTft = Create<LteSlTft>(LteSlTft::RECEIVE, group.address, group.l2Address);
+                m_lteV2xHelper->ActivateSidelinkBearer(Seconds(0.0), ueRespondersDevs, rxTft);
+            }
+            for (uint32_t i = 0; i < ueRespondersDevs.GetN(); i++) {
+                const SidelinkGroup &group = m_sidelinkGroupAddresses[m_activeTxUes.GetN() % m_sidelinkGroups];
+                NetDeviceContainer txUe (ueRespondersDevs.Get(i));
+                m_activeTxUes.Add(txUe);
+                Ptr<LteSlTft> txTft = Create<LteSlTft>(LteSlTft::TRANSMIT, group.address, group.l2Address);
+                m_lteV2xHelper->ActivateSidelinkBearer(Seconds(0.0), txUe, txTft);
+                InstallLteProxyApp(ueRespondersDevs.Get(i)->GetNode(), group.address);
+            }
+            NS_LOG_INFO(m_sidelinkGroups << " shared sidelink groups for " << m_ueDevs.GetN() << " UEs");
+        } else {
+            // One group per UE, all other UEs receive it (as LteV2xHelper::AssociateForV2xBroadcast),
+            // done incrementally so UEs added to the pool later join the existing groups
+            for (const SidelinkGroup &group : m_sidelinkGroupAddresses) {
+                Ptr<LteSlTft> rxTft = Create<LteSlTft>(LteSlTft::RECEIVE, group.address, group.l2Address);
+                m_lteV2xHelper->ActivateSidelinkBearer(Seconds(0.0), ueRespondersDevs, rxTft);
+            }
+            for (uint32_t i = 0; i < ueRespondersDevs.GetN(); i++) {
+                SidelinkGroup group{Ipv4AddressGenerator::NextAddress (Ipv4Mask ("255.0.0.0")),
+                        (uint32_t) m_sidelinkGroupAddresses.size(), ueRespondersDevs.Get(i)};
+                m_sidelinkGroupAddresses.push_back(group);
 
-            NetDeviceContainer txUe (gIt->Get(0));
-            m_activeTxUes.Add(txUe);
-            NetDeviceContainer rxUes = m_lteV2xHelper->RemoveNetDevice ((*gIt), txUe.Get(0));
+                NetDeviceContainer txUe (group.txDevice);
+                m_activeTxUes.Add(txUe);
+                NetDeviceContainer rxUes = m_lteV2xHelper->RemoveNetDevice (m_ueDevs, group.txDevice);
 
-            Ptr<LteSlTft> txTft = Create<LteSlTft>(LteSlTft::TRANSMIT, multicastAddress, groupL2Address); 
-            m_lteV2xHelper->ActivateSidelinkBearer(Seconds(0.0), txUe, txTft);
-            
-            Ptr<LteSlTft> rxTft = Create<LteSlTft>(LteSlTft::RECEIVE, multicastAddress, groupL2Address); 
-            m_lteV2xHelper->ActivateSidelinkBearer(Seconds(0.0), rxUes, rxTft);
+                Ptr<LteSlTft> txTft = Create<LteSlTft>(LteSlTft::TRANSMIT, group.address, group.l2Address); 
+                m_lteV2xHelper->ActivateSidelinkBearer(Seconds(0.0), txUe, txTft);
+                
+                Ptr<LteSlTft> rxTft = Create<LteSlTft>(LteSlTft::RECEIVE, group.address, group.l2Address); 
+                m_lteV2xHelper->ActivateSidelinkBearer(Seconds(0.0), rxUes, rxTft);
 
-            Ptr<MosaicProxyApp> app = CreateObject<MosaicProxyApp>();
-            app->SetNodeManager(this);
-            ueNode->AddApplication(app);
-            app->SetMulticastAddr(multicastAddress);
-            app->SetCommType(m_commType);
-            
-            app->SetTxSocket();
-            app->SetRxSocket();
+                InstallLteProxyApp(group.txDevice->GetNode(), group.address);
+            }
+        }
 
-            multicastAddress.Print(std::cout);
+        m_lteHelper->InstallSidelinkV2xConfiguration(ueRespondersDevs, m_ueSidelinkConfiguration);  
+        ConnectUeTraces(ueRespondersDevs);
+    }
 
-            m_ns3ID2UniqueAddress[ueNode->GetId()] = multicastAddress;
-            groupL2Address++;
-            multicastAddress = Ipv4AddressGenerator::NextAddress (Ipv4Mask ("255.0.0.0"));
+    bool MosaicNodeManager::GrowUePool(){
+        if (m_uePoolGrowth == 0) {
+            return false;
         }
-        
-        // Sidelink configuration
-        m_ueSidelinkConfiguration = CreateObject<LteUeRrcSl>();
-        m_ueSidelinkConfiguration->SetSlEnabled(true);
-        m_ueSidelinkConfiguration->SetV2xEnabled(true);
+        auto start = std::chrono::steady_clock::now();
+        InstallUes(CreateUeNodes(m_uePoolGrowth));
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
 
-        LteRrcSap::SlV2xPreconfiguration preconfiguration;
-        preconfiguration.v2xPreconfigFreqList.freq[0].v2xCommPreconfigGeneral.carrierFreq = 54890;
-        preconfiguration.v2xPreconfigFreqList.freq[0].v2xCommPreconfigGeneral.slBandwidth = 30;
+        m_uePoolGrowths++;
+        m_uePoolGrowthTime += elapsed.count();
+        NS_LOG_WARN("LTE UE pool exhausted, added " << m_uePoolGrowth << " UEs (now " << m_ueDevs.GetN() << ") in "
+                << elapsed.count() << " ms, " << m_uePoolGrowths << " growths took " << m_uePoolGrowthTime
+                << " ms in total. Raise NumOfNodes to avoid growing at runtime.");
+        return true;
+    }
+
+    void MosaicNodeManager::InstallLteProxyApp(Ptr<Node> ueNode, Ipv4Address multicastAddress){
+        Ptr<MosaicProxyApp> app = CreateObject<MosaicProxyApp>();
+        app->SetNodeManager(this);
+        ueNode->AddApplication(app);
+        app->SetMulticastAddr(multicastAddress);
+        app->SetCommType(m_commType);
         
-        preconfiguration.v2xPreconfigFreqList.freq[0].v2xCommTxPoolList.nbPools = 1;
-        preconfiguration.v2xPreconfigFreqList.freq[0].v2xCommRxPoolList.nbPools = 1;
-
-        SlV2xPreconfigPoolFactory pFactory;
-        pFactory.SetHaveUeSelectedResourceConfig (true);
-        pFactory.SetSlSubframe (std::bitset<20> (0xFFFFF));
-        pFactory.SetAdjacencyPscchPssch (true);
-        pFactory.SetSizeSubchannel (10);
-        pFactory.SetNumSubchannel (3);
-        pFactory.SetStartRbSubchannel (0);
-        pFactory.SetStartRbPscchPool (0);
-        pFactory.SetDataTxP0 (-4);
-        pFactory.SetDataTxAlpha (0.9);
-
-        preconfiguration.v2xPreconfigFreqList.freq[0].v2xCommTxPoolList.pools[0] = pFactory.CreatePool ();
-        preconfiguration.v2xPreconfigFreqList.freq[0].v2xCommRxPoolList.pools[0] = pFactory.CreatePool ();
-        m_ueSidelinkConfiguration->SetSlV2xPreconfiguration (preconfiguration); 
+        app->SetTxSocket();
+        app->SetRxSocket();
 
-        m_lteHelper->InstallSidelinkV2xConfiguration(ueRespondersDevs, m_ueSidelinkConfiguration);  
+        if (MosaicLogger::IsEnabled(MOSAIC_LOG_LEVEL_DEBUG)) {
+            std::ostringstream address;
+            multicastAddress.Print(address);
+            MOSAIC_LOG_DEBUG("Installed proxy app on node {} with multicast address {}", ueNode->GetId(), address.str());
+        }
 
-        m_lteHelper->EnableTraces();
+        m_ns3ID2UniqueAddress[ueNode->GetId()] = multicastAddress;
     }
 
     void MosaicNodeManager::InitDsrc(){
-        m_wifiChannelHelper.AddPropagationLoss(m_lossModel);
-        m_wifiChannelHelper.SetPropagationDelay(m_delayModel);
-        m_channel = m_wifiChannelHelper.Create();
+        ObjectFactory lossFactory;
+        lossFactory.SetTypeId(m_lossModel);
+        ObjectFactory delayFactory;
+        delayFactory.SetTypeId(m_delayModel);
+
+        m_channel = CreateObject<MosaicWifiChannel>();
+        m_channel->SetPropagationLossModel(lossFactory.Create<PropagationLossModel>());
+        m_channel->SetPropagationDelayModel(delayFactory.Create<PropagationDelayModel>());
         m_wifiPhyHelper.SetChannel(m_channel);
+        SetupTraces();
+    }
+
+    void MosaicNodeManager::InitAnalytical(){
+        m_analyticalChannel = CreateObject<MosaicAnalyticalChannel>();
+        m_analyticalChannel->SetReceiveCallback(MakeCallback(&MosaicNodeManager::AddAnalyticalRecvPacket, this));
+        SetupTraces();
     }
 
-    void MosaicNodeManager::CreateMosaicNode(int ID, Vector position) {
+    void MosaicNodeManager::CreateMosaicNode(int ID, Vector position, bool isRsu) {
         if (m_isDeactivated[ID]) {
             return;
         }
+        if (isRsu) {
+            m_rsuIds.insert(ID);
+        }
+        m_lastPositionUpdate[ID] = PositionUpdate{position, Simulator::Now()};
         // Install the appropriate device based on communication type
         if (m_commType == DSRC) {
             
@@ -236,6 +509,7 @@ namespace ns3 {
             
             NS_LOG_INFO("Created node " << singleNode->GetId());
             m_mosaic2ns3ID[ID] = singleNode->GetId();
+            m_ns32mosaicID[singleNode->GetId()] = ID;
 
             //Install Wave device
             NS_LOG_INFO("Install WAVE on node " << singleNode->GetId());
@@ -254,20 +528,34 @@ namespace ns3 {
 
             //Install mobility model
             NS_LOG_INFO("Install MosaicMobilityModel on node " << singleNode->GetId());
-            Ptr<ConstantVelocityMobilityModel> mobModel = CreateObject<ConstantVelocityMobilityModel>();
+            Ptr<MosaicMobilityModel> mobModel = CreateObject<MosaicMobilityModel>();
             mobModel->SetPosition(position);
             singleNode->AggregateObject(mobModel);
+            m_channel->UpdatePosition(singleNode->GetId(), position);
 
         } else if (m_commType == LTE) {
-            m_mosaic2ns3ID[ID] = m_ueNodeIdList.front();
-            m_ueNodeIdList.erase(m_ueNodeIdList.begin());
+            if (m_freeUes.empty() && !GrowUePool()) {
+                NS_LOG_ERROR("LTE UE pool exhausted, can not create node " << ID << ", raise NumOfNodes or UePoolGrowth");
+                return;
+            }
+            m_mosaic2ns3ID[ID] = m_freeUes.back();
+            m_freeUes.pop_back();
+            m_ns32mosaicID[m_mosaic2ns3ID[ID]] = ID;
             Ptr<Node> singleNode = NodeList::GetNode(m_mosaic2ns3ID[ID]);
             
             NS_LOG_INFO("Got Node " << singleNode->GetId() << " from node pool");
 
-            Ptr<ConstantVelocityMobilityModel> mobModel = singleNode->GetObject<ConstantVelocityMobilityModel>();
+            Ptr<MosaicMobilityModel> mobModel = singleNode->GetObject<MosaicMobilityModel>();
             mobModel->SetPosition(position); 
             NS_LOG_INFO("Moved Node " << singleNode->GetId() << " to pos:" << position);
+            if (!m_sidelinkOnly) {
+                AttachToNearestEnb(singleNode, position);
+            }
+            if (isRsu) {
+                m_staticNodes->Register(mobModel);
+            }
+        } else if (m_commType == ANALYTICAL) {
+            m_analyticalChannel->UpdatePosition(ID, position);
         }
         else{
             NS_LOG_ERROR("Unknown communication type:" << m_commType);
@@ -275,90 +563,354 @@ namespace ns3 {
         }
     }
 
+    Ptr<LteEnbNetDevice> MosaicNodeManager::GetNearestEnb(const Vector &position) {
+        Ptr<LteEnbNetDevice> nearest;
+        double minDistance = std::numeric_limits<double>::max();
+        for (uint32_t i = 0; i < m_enbDev.GetN(); i++) {
+            Ptr<NetDevice> enbDev = m_enbDev.Get(i);
+            double distance = CalculateDistance(enbDev->GetNode()->GetObject<MobilityModel>()->GetPosition(), position);
+            if (distance < minDistance) {
+                minDistance = distance;
+                nearest = DynamicCast<LteEnbNetDevice> (enbDev);
+            }
+        }
+        return nearest;
+    }
+
+    void MosaicNodeManager::AttachToNearestEnb(Ptr<Node> node, const Vector &position) {
+        Ptr<LteUeNetDevice> ueDev = GetNetDevice<LteUeNetDevice> (node);
+        Ptr<LteEnbNetDevice> target = GetNearestEnb(position);
+        if (ueDev == nullptr || target == nullptr) {
+            NS_LOG_ERROR("Can not attach node " << node->GetId() << ", LTE device or eNodeB missing");
+            return;
+        }
+        if (m_attachedUes.insert(node->GetId()).second) {
+            m_lteHelper->Attach(ueDev, target);
+            NS_LOG_INFO("Attached node " << node->GetId() << " to cell " << target->GetCellId());
+            return;
+        }
+
+        // UE taken again from the pool, it is still connected to the cell it was parked in
+        Ptr<LteUeRrc> rrc = ueDev->GetRrc();
+        if (!m_handover || rrc->GetState() != LteUeRrc::CONNECTED_NORMALLY || rrc->GetCellId() == target->GetCellId()) {
+            return;
+        }
+        for (uint32_t i = 0; i < m_enbDev.GetN(); i++) {
+            Ptr<LteEnbNetDevice> source = DynamicCast<LteEnbNetDevice> (m_enbDev.Get(i));
+            if (source->GetCellId() == rrc->GetCellId()) {
+                m_lteHelper->HandoverRequest(Seconds(0), ueDev, source, target);
+                NS_LOG_INFO("Handover of node " << node->GetId() << " from cell " << source->GetCellId() << " to cell " << target->GetCellId());
+                return;
+            }
+        }
+    }
+
+    Time MosaicNodeManager::GetLookahead(Time time) const {
+        // Outputs are receptions. Transmissions started at or after time are received no earlier
+        // than the minimum delay, receptions already in flight may end before that.
+        Time lookahead = GetMinimumReceptionDelay();
+        Time pending = Time::Max();
+        if (m_commType == DSRC && m_channel != nullptr) {
+            pending = m_channel->GetNextReceptionEnd();
+        } else if (m_commType == ANALYTICAL && m_analyticalChannel != nullptr) {
+            pending = m_analyticalChannel->GetNextDelivery();
+        }
+        if (pending < time + lookahead) {
+            lookahead = Max(pending - time, Seconds(0));
+        }
+        return lookahead;
+    }
+
+    Time MosaicNodeManager::GetMinimumReceptionDelay() const {
+        if (!m_lookahead.IsZero()) {
+            return m_lookahead;
+        }
+        // The propagation delay can be zero, so the bound is the processing delay
+        if (m_commType == DSRC) {
+            // a frame is reported after its end, 802.11p at 10 MHz has a 32 us preamble and an 8 us signal field
+            return MicroSeconds(40);
+        } else if (m_commType == ANALYTICAL && m_analyticalChannel != nullptr) {
+            // every reception is delayed by at least the latency of the channel
+            return m_analyticalChannel->GetLatency();
+        }
+        // The sidelink receptions in flight are hidden in the LTE module and the next subframe
+        // may end right after a packet was queued, so nothing can be promised for LTE
+        return Seconds(0);
+    }
+
     uint32_t MosaicNodeManager::GetNs3NodeId(uint32_t nodeId) {
-        return m_mosaic2ns3ID[nodeId];
+        // no operator[], an unknown id must not create a mapping to node 0
+        auto it = m_mosaic2ns3ID.find(nodeId);
+        if (it == m_mosaic2ns3ID.end()) {
+            return std::numeric_limits<uint32_t>::max();
+        }
+        return it->second;
+    }
+
+    Ptr<Node> MosaicNodeManager::GetNode(uint32_t nodeId) {
+        auto it = m_mosaic2ns3ID.find(nodeId);
+        if (it == m_mosaic2ns3ID.end()) {
+            return nullptr;
+        }
+        return NodeList::GetNode(it->second);
+    }
+
+    Ptr<MosaicProxyApp> MosaicNodeManager::GetProxyApp(Ptr<Node> node) {
+        for (uint32_t i = 0; i < node->GetNApplications(); i++) {
+            Ptr<MosaicProxyApp> app = DynamicCast<MosaicProxyApp> (node->GetApplication(i));
+            if (app != nullptr) {
+                return app;
+            }
+        }
+        return nullptr;
     }
 
     void MosaicNodeManager::SendMsg(uint32_t nodeId, uint32_t protocolID, uint32_t msgID, uint32_t payLength, Ipv4Address ipv4Add) {
         if (m_isDeactivated[nodeId]) {
+            NS_LOG_WARN("Node " << nodeId << " was removed, can not send message " << msgID);
+            m_federate->NotifyCommandError(msgID);
             return;
         }
-        NS_LOG_INFO("Mosaic MosaicNodeManager::SendMsg " << nodeId);
-        Ptr<Node> node = NodeList::GetNode(m_mosaic2ns3ID[nodeId]);
-        
-        Ptr<MosaicProxyApp> app = DynamicCast<MosaicProxyApp> (node->GetApplication(0));
+        MOSAIC_LOG_DEBUG("MosaicNodeManager::SendMsg node {} message {}", nodeId, msgID);
+        if (m_commType == ANALYTICAL) {
+            if (!m_analyticalChannel->Contains(nodeId)) {
+                NS_LOG_ERROR("Node " << nodeId << " is unknown, can not send message " << msgID);
+                m_federate->NotifyCommandError(msgID);
+                return;
+            }
+            m_analyticalChannel->Send(nodeId, msgID, payLength);
+            if (IsTraced(TRACE_SEND)) {
+                m_traceWriter->Append(m_traceTables[TRACE_SEND], (int64_t) Simulator::Now().GetNanoSeconds(), nodeId, msgID);
+            }
+            return;
+        }
+        Ptr<Node> node = GetNode(nodeId);
+        if (node == nullptr) {
+            NS_LOG_ERROR("Node " << nodeId << " is unknown, can not send message " << msgID);
+            m_federate->NotifyCommandError(msgID);
+            return;
+        }
+
+        Ptr<MosaicProxyApp> app = GetProxyApp(node);
         if (app == nullptr) {
             NS_LOG_ERROR("Node " << nodeId << " was not initialized properly, MosaicProxyApp is missing");
+            m_federate->NotifyCommandError(msgID);
             return;
         }
 
         app->TransmitPacket(protocolID, msgID, payLength, ipv4Add);
+        if (IsTraced(TRACE_SEND)) {
+            m_traceWriter->Append(m_traceTables[TRACE_SEND], (int64_t) Simulator::Now().GetNanoSeconds(), nodeId, msgID);
+        }
     }
 
     void MosaicNodeManager::AddRecvPacket(unsigned long long recvTime, Ptr<Packet> pack, int nodeID, int msgID) {
-        if (m_isDeactivated[nodeID]) {
+        // packets received by removed nodes or by unassigned pool nodes are not reported
+        auto it = m_ns32mosaicID.find(nodeID);
+        if (it == m_ns32mosaicID.end() || m_federate == nullptr) {
+            return;
+        }
+        m_federate->NotifyReceive(recvTime, it->second, msgID);
+        if (IsTraced(TRACE_RECEIVE)) {
+            m_traceWriter->Append(m_traceTables[TRACE_RECEIVE], (int64_t) recvTime, it->second, (uint32_t) msgID);
+        }
+    }
+
+    void MosaicNodeManager::AddAnalyticalRecvPacket(uint32_t nodeId, uint32_t msgID) {
+        if (m_federate == nullptr) {
             return;
         }
-        m_serverPtr->AddRecvPacket(recvTime, pack, nodeID, msgID);
+        const uint64_t recvTime = Simulator::Now().GetNanoSeconds();
+        m_federate->NotifyReceive(recvTime, nodeId, msgID);
+        if (IsTraced(TRACE_RECEIVE)) {
+            m_traceWriter->Append(m_traceTables[TRACE_RECEIVE], (int64_t) recvTime, nodeId, msgID);
+        }
     }
 
     void MosaicNodeManager::UpdateNodePosition(uint32_t nodeId, Vector position) {
         if (m_isDeactivated[nodeId]) {
             return;
         }
+        if (m_commType == ANALYTICAL) {
+            if (!m_analyticalChannel->Contains(nodeId)) {
+                NS_LOG_ERROR("Node " << nodeId << " is unknown, can not update its position");
+                return;
+            }
+            m_analyticalChannel->UpdatePosition(nodeId, position);
+            return;
+        }
 
-        Ptr<Node> node = NodeList::GetNode(nodeId);
-        Ptr<MobilityModel> mobModel = node->GetObject<MobilityModel> ();
-        mobModel->SetPosition(position);
+        Ptr<Node> node = GetNode(nodeId);
+        if (node == nullptr) {
+            NS_LOG_ERROR("Node " << nodeId << " is unknown, can not update its position");
+            return;
+        }
+        Ptr<MosaicMobilityModel> mobModel = node->GetObject<MosaicMobilityModel>();
+
+        PositionUpdate &last = m_lastPositionUpdate[nodeId];
+        Vector velocity(0.0, 0.0, 0.0);
+        const double elapsed = (Simulator::Now() - last.time).GetSeconds();
+        if (m_deadReckoning && !IsRsu(nodeId) && elapsed > 0) {
+            velocity = Vector((position.x - last.position.x) / elapsed,
+                    (position.y - last.position.y) / elapsed,
+                    (position.z - last.position.z) / elapsed);
+        }
+        last = PositionUpdate{position, Simulator::Now()};
 
+        // Every course change triggers the building and LTE consistency checks. Updates the
+        // model already matches (parked vehicles, or vehicles extrapolated accurately enough)
+        // keep the position, only a changed velocity is taken over.
+        if (CalculateDistance(mobModel->GetPosition(), position) <= m_positionUpdateThreshold) {
+            m_skippedPositionUpdates++;
+            MOSAIC_LOG_DEBUG("Skipped position update of node {}, {} skipped so far", nodeId, m_skippedPositionUpdates);
+            if (m_deadReckoning && CalculateDistance(mobModel->GetVelocity(), velocity) > 0) {
+                mobModel->SetVelocity(velocity);
+            }
+        } else {
+            if (m_deadReckoning) {
+                mobModel->SetPositionAndVelocity(position, velocity);
+            } else {
+                mobModel->SetPosition(position);
+            }
+            if (m_commType == LTE && IsRsu(nodeId)) {
+                m_staticNodes->Invalidate(mobModel);
+            }
+        }
+
+        if (m_commType == DSRC) {
+            // with dead reckoning the grid lags behind the extrapolated position until the next update,
+            // the cutoff range is a coarse bound, the loss is computed from the actual positions
+            m_channel->UpdatePosition(node->GetId(), mobModel->GetPosition());
+        }
+    }
+
+    bool MosaicNodeManager::IsRsu(uint32_t nodeId) const {
+        return m_rsuIds.find(nodeId) != m_rsuIds.end();
     }
 
     void MosaicNodeManager::DeactivateNode(uint32_t nodeId) {
         if (m_isDeactivated[nodeId]) {
             return;
         }
-        
-        Ptr<Node> node = NodeList::GetNode(nodeId);
-        Ptr<WifiNetDevice> netDev = DynamicCast<WifiNetDevice> (node->GetDevice(1));
-        
-        if (netDev == nullptr) {
-            NS_LOG_ERROR("Node " << nodeId << " has no WifiNetDevice");
+        if (m_commType == ANALYTICAL) {
+            if (!m_analyticalChannel->Contains(nodeId)) {
+                NS_LOG_ERROR("Node " << nodeId << " is unknown, can not remove it");
+                return;
+            }
+            m_analyticalChannel->Remove(nodeId);
+            m_rsuIds.erase(nodeId);
+            m_lastPositionUpdate.erase(nodeId);
+            m_isDeactivated[nodeId] = true;
+            NS_LOG_INFO("Removed node " << nodeId);
             return;
         }
-        //Workaround: set a channel number, which no other phy uses. Channel will this way not let the phy
-        //receive. Unfortunately, phys cannot be removed from channel, once added.
-        netDev->GetPhy()->SetChannelNumber(0x0);
-        netDev->GetPhy()->SetSleepMode();
-        
+
+        Ptr<Node> node = GetNode(nodeId);
+        if (node == nullptr) {
+            NS_LOG_ERROR("Node " << nodeId << " is unknown, can not remove it");
+            return;
+        }
+
+        //Stop the app first, so no further packets are sent or reported for this node
+        Ptr<MosaicProxyApp> app = GetProxyApp(node);
+        if (app != nullptr) {
+            app->Disable();
+        }
+
+        if (m_commType == DSRC) {
+            // ns-3 nodes can not be deleted during the simulation, hence everything which costs
+            // per transmission or per event is released and the node itself stays as an empty shell
+            if (app != nullptr) {
+                app->CloseSockets();
+            }
+            Ptr<WifiNetDevice> netDev = GetNetDevice<WifiNetDevice> (node);
+            if (netDev == nullptr) {
+                NS_LOG_ERROR("Node " << nodeId << " has no WifiNetDevice");
+            } else {
+                //Drop the phy from the channel, so it is no longer part of any transmission fan-out
+                Ptr<MosaicWifiPhy> phy = DynamicCast<MosaicWifiPhy> (netDev->GetPhy());
+                if (phy != nullptr) {
+                    phy->DetachMosaicChannel();
+                }
+                netDev->GetPhy()->SetSleepMode();
+            }
+            Ptr<MosaicMobilityModel> mobModel = node->GetObject<MosaicMobilityModel>();
+            if (mobModel != nullptr) {
+                mobModel->SetVelocity(Vector(0.0, 0.0, 0.0));
+            }
+        } else if (m_commType == LTE) {
+            // The UE phys are owned by the spectrum channels of the LteHelper, which do not support
+            // removal. The UE is parked outside of the scenario and handed back to the pool, so the
+            // number of phys on the channel stays bounded by the pool size. The sockets are bound to
+            // the sidelink group of the UE and are reused by the next node taking the UE from the pool.
+            Ptr<MosaicMobilityModel> mobModel = node->GetObject<MosaicMobilityModel>();
+            if (IsRsu(nodeId)) {
+                m_staticNodes->Unregister(mobModel);
+            }
+            mobModel->SetPositionAndVelocity(Vector(10000, 10000, 0), Vector(0.0, 0.0, 0.0));
+            m_freeUes.push_back(node->GetId());
+        }
+
+        m_ns32mosaicID.erase(node->GetId());
+        m_mosaic2ns3ID.erase(nodeId);
+        m_rsuIds.erase(nodeId);
+        m_lastPositionUpdate.erase(nodeId);
         m_isDeactivated[nodeId] = true;
+        NS_LOG_INFO("Removed node " << nodeId << " (ns-3 node " << node->GetId() << ")");
+    }
+
+    void MosaicNodeManager::SendMsgBatch(std::vector<MosaicSendRequest> batch) {
+        MOSAIC_LOG_DEBUG("MosaicNodeManager::SendMsgBatch {} messages", batch.size());
+        for (const MosaicSendRequest &request : batch) {
+            SendMsg(request.nodeId, 0, request.msgID, request.payLength, request.destination);
+        }
     }
 
     /**
      * @brief Evaluates configuration message and applies it to the node
      */
-    void MosaicNodeManager::ConfigureNodeRadio(uint32_t nodeId, bool radioTurnedOn, int transmitPower) {
+    void MosaicNodeManager::ConfigureNodeRadio(uint32_t nodeId, bool radioTurnedOn, int transmitPower, uint32_t msgID) {
         if (m_isDeactivated[nodeId]) {
+            NS_LOG_WARN("Node " << nodeId << " was removed, can not configure its radio");
+            m_federate->NotifyCommandError(msgID);
+            return;
+        }
+        if (m_commType == ANALYTICAL) {
+            if (!m_analyticalChannel->Contains(nodeId)) {
+                NS_LOG_ERROR("Node " << nodeId << " is unknown, can not configure its radio");
+                m_federate->NotifyCommandError(msgID);
+                return;
+            }
+            // the range does not depend on the transmit power
+            m_analyticalChannel->SetRadioEnabled(nodeId, radioTurnedOn);
             return;
         }
 
-        Ptr<Node> node = NodeList::GetNode(nodeId);
-        if (node->GetNApplications() > 0) {
-            Ptr<Application> app = node->GetApplication(0);
-        } else {
+        Ptr<Node> node = GetNode(nodeId);
+        if (node == nullptr) {
+            NS_LOG_ERROR("Node " << nodeId << " is unknown, can not configure its radio");
+            m_federate->NotifyCommandError(msgID);
             return;
         }
-        Ptr<Application> app = node->GetApplication(0);
-        Ptr<MosaicProxyApp> ssa = app->GetObject<MosaicProxyApp>();
+        Ptr<MosaicProxyApp> ssa = GetProxyApp(node);
         if (!ssa) {
             NS_LOG_ERROR("No app found on node " << nodeId << " !");
+            m_federate->NotifyCommandError(msgID);
             return;
         }
+        if (m_commType == LTE && IsRsu(nodeId)) {
+            // conservative, the cached values do not depend on the radio settings of the current models
+            m_staticNodes->Invalidate(node->GetObject<MobilityModel>());
+            NS_LOG_INFO("Invalidated path loss cache of RSU " << nodeId << ", "
+                    << m_staticNodes->GetHits() << " hits, "
+                    << m_staticNodes->GetMisses() << " misses so far");
+        }
         if (radioTurnedOn) {
             ssa->Enable();
             if (transmitPower > -1) {
                 double txDBm = 10 * log10((double) transmitPower);
                 if (m_commType == DSRC) {
-                    Ptr<WifiNetDevice> netDev = DynamicCast<WifiNetDevice> (node->GetDevice(1));
+                    Ptr<WifiNetDevice> netDev = GetNetDevice<WifiNetDevice> (node);
                     if (netDev == nullptr) {
                         NS_LOG_ERROR("Inconsistency: no matching NetDevice found on node while configuring");
                         return;
@@ -369,7 +921,7 @@ namespace ns3 {
                         wavePhy->SetTxPowerEnd(txDBm);
                     }
                 } else if (m_commType == LTE) {
-                    Ptr<LteUeNetDevice> netDev = DynamicCast<LteUeNetDevice> (node->GetDevice(0));
+                    Ptr<LteUeNetDevice> netDev = GetNetDevice<LteUeNetDevice> (node);
                     if (netDev == nullptr) {
                         NS_LOG_ERROR("Inconsistency: no matching NetDevice found on node while configuring");
                         return;
@@ -404,4 +956,93 @@ namespace ns3 {
         m_lteHelper->InstallSidelinkV2xConfiguration (m_ueDevs, m_ueSidelinkConfiguration);
 
     }
+
+    void MosaicNodeManager::ConfigureSidelink(SidelinkPreset preset){
+        LteRrcSap::SlV2xPreconfiguration preconfiguration = CreateSidelinkPreconfiguration(preset);
+        m_activeSidelinkPreset = preset;
+        ConfigureSidelink(preconfiguration);
+        NS_LOG_INFO("Configured sidelink: carrierFreq=" << preset.carrierFreq << " slBandwidth=" << preset.slBandwidth
+                << " txPools=" << (unsigned) preconfiguration.v2xPreconfigFreqList.freq[0].v2xCommTxPoolList.nbPools
+                << " rxPools=" << (unsigned) preconfiguration.v2xPreconfigFreqList.freq[0].v2xCommRxPoolList.nbPools);
+    }
+
+    void MosaicNodeManager::UpdateSidelink(SidelinkUpdate update) {
+        SidelinkPreset preset = m_activeSidelinkPreset;
+        if (!update.preset.empty()) {
+            const SidelinkPreset *named = GetSidelinkPreset(update.preset);
+            if (named == nullptr) {
+                NS_LOG_ERROR("Unknown sidelink preset " << update.preset << ", ignoring the sidelink configuration");
+                if (update.hasMessageId) {
+                    m_federate->NotifyCommandError(update.messageId);
+                }
+                return;
+            }
+            preset = *named;
+        }
+        if (update.hasCarrierFreq) {
+            preset.carrierFreq = update.carrierFreq;
+        }
+        if (update.hasSlBandwidth) {
+            preset.slBandwidth = update.slBandwidth;
+        }
+        if (!update.txPools.empty() && !update.rxPools.empty()) {
+            preset.txPools = std::move(update.txPools);
+            preset.rxPools = std::move(update.rxPools);
+        }
+        ConfigureSidelink(std::move(preset));
+    }
+
+    const SidelinkPreset *MosaicNodeManager::GetSidelinkPreset(const std::string &name) const {
+        auto it = m_sidelinkConfig.presets.find(name);
+        if (it == m_sidelinkConfig.presets.end()) {
+            return nullptr;
+        }
+        return &it->second;
+    }
+
+    const SidelinkPreset &MosaicNodeManager::GetActiveSidelinkPreset() const {
+        return m_activeSidelinkPreset;
+    }
+
+    LteRrcSap::SlV2xPreconfiguration MosaicNodeManager::CreateSidelinkPreconfiguration(const SidelinkPreset &preset){
+        LteRrcSap::SlV2xPreconfiguration preconfiguration;
+        preconfiguration.v2xPreconfigFreqList.freq[0].v2xCommPreconfigGeneral.carrierFreq = preset.carrierFreq;
+        preconfiguration.v2xPreconfigFreqList.freq[0].v2xCommPreconfigGeneral.slBandwidth = preset.slBandwidth;
+
+        auto createPool = [](const SidelinkPoolConfig &pool) {
+            SlV2xPreconfigPoolFactory pFactory;
+            pFactory.SetHaveUeSelectedResourceConfig (true);
+            pFactory.SetSlSubframe (std::bitset<20> (pool.slSubframe));
+            pFactory.SetAdjacencyPscchPssch (pool.adjacencyPscchPssch);
+            pFactory.SetSizeSubchannel (pool.sizeSubchannel);
+            pFactory.SetNumSubchannel (pool.numSubchannel);
+            pFactory.SetStartRbSubchannel (pool.startRbSubchannel);
+            pFactory.SetStartRbPscchPool (pool.startRbPscchPool);
+            pFactory.SetDataTxP0 (pool.dataTxP0);
+            pFactory.SetDataTxAlpha (pool.dataTxAlpha);
+            return pFactory.CreatePool ();
+        };
+
+        auto &txPoolList = preconfiguration.v2xPreconfigFreqList.freq[0].v2xCommTxPoolList;
+        auto &rxPoolList = preconfiguration.v2xPreconfigFreqList.freq[0].v2xCommRxPoolList;
+        const std::vector<SidelinkPoolConfig> defaultPools(1);
+        const std::vector<SidelinkPoolConfig> &txPools = preset.txPools.empty() ? defaultPools : preset.txPools;
+        const std::vector<SidelinkPoolConfig> &rxPools = preset.rxPools.empty() ? defaultPools : preset.rxPools;
+
+        // the pool lists are fixed size arrays in LteRrcSap
+        const std::size_t maxTxPools = sizeof(txPoolList.pools) / sizeof(txPoolList.pools[0]);
+        const std::size_t maxRxPools = sizeof(rxPoolList.pools) / sizeof(rxPoolList.pools[0]);
+        if (txPools.size() > maxTxPools || rxPools.size() > maxRxPools) {
+            NS_LOG_WARN("Too many sidelink pools, at most " << maxTxPools << " tx and " << maxRxPools << " rx pools are used");
+        }
+        txPoolList.nbPools = std::min(txPools.size(), maxTxPools);
+        for (std::size_t i = 0; i < txPoolList.nbPools; i++) {
+            txPoolList.pools[i] = createPool(txPools[i]);
+        }
+        rxPoolList.nbPools = std::min(rxPools.size(), maxRxPools);
+        for (std::size_t i = 0; i < rxPoolList.nbPools; i++) {
+            rxPoolList.pools[i] = createPool(rxPools[i]);
+        }
+        return preconfiguration;
+    }
 }
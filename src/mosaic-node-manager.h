@@ -23,17 +23,24 @@
 #ifndef MOSAICNODEMANAGER_H
 #define MOSAICNODEMANAGER_H
 
+#include <array>
+#include <memory>
 #include <unordered_map>
+#include <unordered_set>
 
 #include "ns3/ipv4-address-helper.h"
 #include "ns3/node-container.h"
 #include "ns3/wifi-80211p-helper.h"
 #include "ns3/wave-mac-helper.h"
 #include "ns3/vector.h"
-#include "ns3/yans-wifi-channel.h"
-#include "ns3/yans-wifi-helper.h"
+#include "mosaic-analytical-channel.h"
+#include "mosaic-cached-propagation-loss-model.h"
+#include "mosaic-wifi-channel.h"
+#include "mosaic-wifi-phy.h"
 #include "ns3/lte-helper.h"
 #include "ClientServerChannel.h"
+#include "mosaic-federate-config.h"
+#include "mosaic-trace-writer.h"
 
 #include "ns3/lte-helper.h"
 #include "ns3/lte-v2x-helper.h"
@@ -50,6 +57,8 @@
 
 #include "ns3/lte-ue-phy.h"
 #include "ns3/lte-ue-mac.h"
+#include "ns3/lte-enb-net-device.h"
+#include "ns3/lte-common.h"
 #include "ns3/callback.h"
 #include <sstream>
 
@@ -59,7 +68,18 @@ namespace ns3 {
     using namespace ClientServerChannelSpace;
 
     //Forward declaration to prevent circular dependency
-    class MosaicNs3Server;
+    class MosaicFederate;
+    class MosaicProxyApp;
+
+    /**
+     * @brief one transmission of a MSG_SEND_BATCH
+     */
+    struct MosaicSendRequest {
+        uint32_t nodeId;
+        uint32_t msgID;
+        uint32_t payLength;
+        Ipv4Address destination;
+    };
 
     // Define the communication types
 
@@ -75,15 +95,48 @@ namespace ns3 {
         MosaicNodeManager();
         virtual ~MosaicNodeManager() = default;
 
-        void Configure(MosaicNs3Server* serverPtr, CommunicationType commType);
-        void InitLte(int numOfNode=5);
+        void Configure(MosaicFederate* federate, const FederateConfig &config);
+        void InitLte(int numOfNode=5, const LteTopologyConfig &topology = LteTopologyConfig(),
+                const SidelinkConfig &sidelink = SidelinkConfig());
         void InitDsrc();
 
-        void CreateMosaicNode(int ID, Vector position);
+        /**
+         * @brief set up the ANALYTICAL communication type, nodes are only positions in a MosaicAnalyticalChannel
+         */
+        void InitAnalytical();
+
+        void CreateMosaicNode(int ID, Vector position, bool isRsu = false);
         void UpdateNodePosition(uint32_t nodeId, Vector position);
-        void ConfigureNodeRadio(uint32_t nodeId, bool radioTurnedOn, int transmitPower);
+        void ConfigureNodeRadio(uint32_t nodeId, bool radioTurnedOn, int transmitPower, uint32_t msgID);
         void ConfigureSidelink(LteRrcSap::SlV2xPreconfiguration preconfiguration);
+
+        /**
+         * @brief apply a sidelink preset to all UEs
+         */
+        void ConfigureSidelink(SidelinkPreset preset);
+
+        /**
+         * @brief apply a change to the active sidelink preset to all UEs
+         */
+        void UpdateSidelink(SidelinkUpdate update);
+
+        /**
+         * @brief look up a preset loaded from the config file
+         *
+         * @return the preset or nullptr, if there is no preset with this name
+         */
+        const SidelinkPreset *GetSidelinkPreset(const std::string &name) const;
+
+        /**
+         * @brief the preset applied last
+         */
+        const SidelinkPreset &GetActiveSidelinkPreset() const;
         void SendMsg(uint32_t nodeId, uint32_t protocolID, uint32_t msgID, uint32_t payLenght, Ipv4Address ipv4Add);
+
+        /**
+         * @brief start all transmissions of a batch, in the order of the batch
+         */
+        void SendMsgBatch(std::vector<MosaicSendRequest> batch);
         bool ActivateNode(uint32_t nodeId);
         void DeactivateNode(uint32_t nodeId);
 
@@ -91,26 +144,174 @@ namespace ns3 {
 
         uint32_t GetNs3NodeId(uint32_t nodeId);
 
+        /**
+         * @brief the federate reports no reception before time plus the returned lookahead
+         *
+         * @param time the time of the next event or the time reached by a time advance
+         * @return the minimum reception delay, bounded by the earliest reception in flight
+         */
+        Time GetLookahead(Time time) const;
+
         //Must be public to be accessible by ns-3 object creation routine
         std::string m_lossModel;
         std::string m_delayModel;
+        std::string m_lteLossModel;
 
     private:
 
-        void SetupLteTraces();
-        void OnConnectionEstablished(uint64_t imsi, uint16_t cellId, uint16_t rnti);
-        MosaicNs3Server *m_serverPtr;
+        virtual void DoDispose(void);
+
+        /**
+         * @brief resolve a MOSAIC node id to its ns-3 node
+         *
+         * @return the node or nullptr, if the id is unknown or the node was removed
+         */
+        Ptr<Node> GetNode(uint32_t nodeId);
+
+        Ptr<MosaicProxyApp> GetProxyApp(Ptr<Node> node);
+
+        bool IsRsu(uint32_t nodeId) const;
+
+        /**
+         * @brief minimum time between the start of a transmission and the earliest reception it can cause
+         */
+        Time GetMinimumReceptionDelay() const;
+
+        /**
+         * @brief find the first net device of the given type on a node
+         */
+        template <class T>
+        Ptr<T> GetNetDevice(Ptr<Node> node) {
+            for (uint32_t i = 0; i < node->GetNDevices(); i++) {
+                Ptr<T> device = DynamicCast<T> (node->GetDevice(i));
+                if (device != nullptr) {
+                    return device;
+                }
+            }
+            return nullptr;
+        }
+
+        /**
+         * @brief the eNodeB closest to the given position
+         */
+        Ptr<LteEnbNetDevice> GetNearestEnb(const Vector &position);
+
+        /**
+         * @brief attach a pool UE to the eNodeB closest to its new position, or hand it over if it is already attached
+         */
+        void AttachToNearestEnb(Ptr<Node> node, const Vector &position);
+
+        /**
+         * @brief create the eNodeBs of the topology, not used in sidelink only mode
+         */
+        void InstallEnbs(const LteTopologyConfig &topology);
+
+        static LteRrcSap::SlV2xPreconfiguration CreateSidelinkPreconfiguration(const SidelinkPreset &preset);
+
+        /**
+         * @brief create UE nodes parked outside of the scenario
+         */
+        NodeContainer CreateUeNodes(uint32_t count);
+
+        /**
+         * @brief install LTE devices, IP, sidelink groups and the MosaicProxyApp on new UEs and add them to the pool
+         */
+        void InstallUes(NodeContainer ueAllNodes);
+
+        /**
+         * @brief add UePoolGrowth UEs to the pool at runtime
+         *
+         * @return false, if the pool must not grow
+         */
+        bool GrowUePool();
+
+        /**
+         * @brief install the MosaicProxyApp on a UE, sending to the given sidelink group
+         */
+        void InstallLteProxyApp(Ptr<Node> ueNode, Ipv4Address multicastAddress);
+
+        /**
+         * @brief report a reception of the analytical channel
+         */
+        void AddAnalyticalRecvPacket(uint32_t nodeId, uint32_t msgID);
+
+        /**
+         * @brief open the trace file and connect the trace sources of the Traces config section
+         *
+         * Sources, each written to a table of the same name:
+         *   Send, Receive   messages of the MOSAIC nodes, both communication types
+         *   DlTxPhy         LteEnbPhy DlPhyTransmission
+         *   UlTxPhy         LteUePhy UlPhyTransmission
+         *   DlRxPhy         LteSpectrumPhy DlPhyReception of the UEs
+         *   UlRxPhy         LteSpectrumPhy UlPhyReception of the eNodeBs
+         *   RsrpSinr        LteUePhy ReportCurrentCellRsrpSinr
+         * This replaces LteHelper::EnableTraces, which writes every PHY, MAC, RLC and PDCP
+         * statistic as text.
+         */
+        void SetupTraces();
+
+        /**
+         * @brief connect the enabled LTE trace sources of new UEs
+         */
+        void ConnectUeTraces(NetDeviceContainer ueDevs);
+
+        void TraceDlTxPhy(PhyTransmissionStatParameters params);
+        void TraceUlTxPhy(PhyTransmissionStatParameters params);
+        void TraceDlRxPhy(PhyReceptionStatParameters params);
+        void TraceUlRxPhy(PhyReceptionStatParameters params);
+        void TraceRsrpSinr(uint16_t cellId, uint16_t rnti, double rsrp, double sinr, uint8_t componentCarrierId);
+        void WritePhyTransmission(uint16_t table, const PhyTransmissionStatParameters &params);
+        void WritePhyReception(uint16_t table, const PhyReceptionStatParameters &params);
+
+        enum TraceSource {
+            TRACE_SEND,
+            TRACE_RECEIVE,
+            TRACE_DL_TX_PHY,
+            TRACE_UL_TX_PHY,
+            TRACE_DL_RX_PHY,
+            TRACE_UL_RX_PHY,
+            TRACE_RSRP_SINR,
+            TRACE_SOURCES
+        };
+
+        bool IsTraced(TraceSource source) const {
+            return m_traceWriter != nullptr && m_traceTables[source] >= 0;
+        }
+
+        MosaicFederate *m_federate = nullptr;
         std::map<uint32_t, uint32_t> m_mosaic2ns3ID;
+        std::unordered_map<uint32_t, uint32_t> m_ns32mosaicID;
         std::map<uint32_t, Ipv4Address> m_ns3ID2UniqueAddress;
         std::unordered_map<uint32_t, bool> m_isDeactivated;
+        // MOSAIC ids of the RSUs, they do not move after creation
+        std::unordered_set<uint32_t> m_rsuIds;
+
+        // Position update filter
+        struct PositionUpdate {
+            Vector position;
+            Time time;
+        };
+        std::unordered_map<uint32_t, PositionUpdate> m_lastPositionUpdate;
+        double m_positionUpdateThreshold;
+        bool m_deadReckoning;
+        uint64_t m_skippedPositionUpdates = 0;
+
+        uint32_t m_sidelinkGroups;
+        uint32_t m_uePoolGrowth;
+        bool m_sidelinkOnly;
+        Time m_lookahead;
+
+        TraceConfig m_traceConfig;
+        std::unique_ptr<MosaicTraceWriter> m_traceWriter;
+        // table of each trace source, -1 if the source is not traced
+        std::array<int, TRACE_SOURCES> m_traceTables;
 
         // DSRC
         // Channel
-        YansWifiChannelHelper m_wifiChannelHelper;
-        Ptr<YansWifiChannel> m_channel;
+        Ptr<MosaicWifiChannel> m_channel;
 
         // PHY
-        YansWifiPhyHelper m_wifiPhyHelper = YansWifiPhyHelper::Default();
+        MosaicWifiPhyHelper m_wifiPhyHelper = MosaicWifiPhyHelper::Default();
 
         // MAC
         NqosWaveMacHelper m_waveMacHelper = NqosWaveMacHelper::Default();
@@ -121,21 +322,46 @@ namespace ns3 {
         Ipv4AddressHelper m_ipAddressHelper;
         // DSRC End
 
+        // ANALYTICAL, keyed by the MOSAIC ids, there are no ns-3 nodes
+        Ptr<MosaicAnalyticalChannel> m_analyticalChannel;
+
         // LTE
         // LTE Helper
         std::map<uint32_t, uint32_t> m_ns3Id2DeviceId;
         Ptr<LteHelper> m_lteHelper;
         Ptr<LteV2xHelper> m_lteV2xHelper;
+        // RSUs and eNBs, whose links the path loss models cache
+        Ptr<MosaicStaticNodeRegistry> m_staticNodes;
         Ptr<LteUeRrcSl> m_ueSidelinkConfiguration;
+        SidelinkConfig m_sidelinkConfig;
+        SidelinkPreset m_activeSidelinkPreset;
         
         NetDeviceContainer m_ueDevs;    
         NetDeviceContainer m_enbDev;
         CommunicationType m_commType;
-        std::vector<uint32_t> m_ueNodeIdList;
+        // nullptr in sidelink only mode
+        Ptr<PointToPointEpcHelper> m_epcHelper;
+        // addresses of the UEs in sidelink only mode
+        Ipv4AddressHelper m_ueAddressHelper;
+        // ns-3 ids of the UEs not taken by a node, used as a stack
+        std::vector<uint32_t> m_freeUes;
+        uint32_t m_uePoolGrowths = 0;
+        double m_uePoolGrowthTime = 0.0;
+
+        struct SidelinkGroup {
+            Ipv4Address address;
+            uint32_t l2Address;
+            // the only transmitter of the group, nullptr for shared groups
+            Ptr<NetDevice> txDevice;
+        };
+        std::vector<SidelinkGroup> m_sidelinkGroupAddresses;
         
         NetDeviceContainer m_activeTxUes;
         NodeContainer m_ueNodes;
         NodeContainer m_eNodeB;
+        bool m_handover = false;
+        // ns-3 ids of the pool UEs which were attached to a cell once
+        std::unordered_set<uint32_t> m_attachedUes;
         // LTE End
 
 
@@ -23,38 +23,39 @@
 #include "mosaic-ns3-server.h"
 
 #include "ns3/node-list.h"
-#include "mosaic-simulator-impl.h"
 #include "ns3/log.h"
+#include "mosaic-logger.h"
 
 NS_LOG_COMPONENT_DEFINE("MosaicNs3Server");
 
 namespace ns3 {
     using namespace ClientServerChannelSpace;
 
+    // protocol features this federate implements, the ambassador gets the intersection with its request
+    static const uint32_t SUPPORTED_FEATURES = FEATURE_PIPELINED | FEATURE_ENVELOPE | FEATURE_FIXED_CODEC | FEATURE_COMPRESSION;
+
+
     /**
      * @brief initialize the MosaicNs3Server with the given port and the given MosaicNodemanager
      *
      * @param port  port for receiving the commands from MOSAIC
      * @param MosaicNodeManger MosaicNodeManger given from the NS3 starter script
      */
-    MosaicNs3Server::MosaicNs3Server(int port, int cmdPort, std::string commType) {
+    MosaicNs3Server::MosaicNs3Server(int port, int cmdPort, const FederateConfig &config) : m_federate(config) {
         std::cout << "Starting federate on port " << port << "\n";
-        if (commType == "DSRC"){
-            m_commType = CommunicationType::DSRC;
-        }
-        else if (commType == "LTE"){
-            m_commType = CommunicationType::LTE;
-        }
-        else{
-            NS_LOG_ERROR("Unknown communication type:" << commType);
+        if (m_federate.GetCommType() != CommunicationType::DSRC && m_federate.GetCommType() != CommunicationType::LTE
+                && m_federate.GetCommType() != CommunicationType::ANALYTICAL) {
+            NS_LOG_ERROR("Unknown communication type:" << config.commType);
+            m_closeConnection = true;
             return;
-        }            
+        }
 
         if (cmdPort > 0) {
             std::cout << "Once connected, federate will listen to commands on port " << cmdPort << "\n";
         }
-        m_nodeManager = CreateObject<MosaicNodeManager>();
-        m_nodeManager->Configure(this, m_commType);
+        m_federate.SetNextEventCallback([this](uint64_t time) { writeNextTime(time); });
+        m_federate.SetReceiveCallback([this](uint64_t time, uint32_t nodeId, int msgID) { AddRecvPacket(time, nodeId, msgID); });
+        m_federate.SetCommandErrorCallback([this](uint32_t msgID) { ReportCommandError(msgID); });
         m_closeConnection = false;
 
         std::cout << "Trying to prepare federateAmbassadorChannel on port " << port << " " << std::endl;
@@ -67,8 +68,10 @@ namespace ns3 {
         if (actPort < 1) {
             exit(-1);
         }
-        federateAmbassadorChannel.writePort(actPort);
-        ambassadorFederateChannel.connect();
+        // newer ambassadors may skip the second connection and multiplex both channels on the first one
+        federateAmbassadorChannel.writePort(actPort, true);
+        const bool multiplexed = ambassadorFederateChannel.connectOrMultiplex(federateAmbassadorChannel);
+        std::cout << "Mosaic-NS3-Server uses " << (multiplexed ? "one multiplexed connection" : "two connections") << std::endl;
 
         if (ambassadorFederateChannel.readCommand() == CMD_INIT) {
             CSC_init_return init_message;
@@ -77,6 +80,27 @@ namespace ns3 {
             m_endTime = init_message.end_time;
             if (m_startTime >= 0 && m_endTime >= 0 && m_endTime >= m_startTime) {
                 ambassadorFederateChannel.writeCommand(CMD_SUCCESS);
+                // ambassadors without feature support do not expect the feature message
+                if (init_message.has_features) {
+                    m_features = init_message.features & SUPPORTED_FEATURES;
+                    if (multiplexed) {
+                        m_features |= FEATURE_MULTIPLEX;
+                    }
+                    if (m_features & FEATURE_FIXED_CODEC) {
+                        // the fixed layout already sends the frequent commands as one frame
+                        m_features &= ~FEATURE_ENVELOPE;
+                    }
+                    ambassadorFederateChannel.writeFeatures(m_features);
+                    ambassadorFederateChannel.setPipelined(m_features & FEATURE_PIPELINED);
+                    // the feature message is the last frame of the old layout
+                    ambassadorFederateChannel.setEnvelope(m_features & FEATURE_ENVELOPE);
+                    federateAmbassadorChannel.setEnvelope(m_features & FEATURE_ENVELOPE);
+                    ambassadorFederateChannel.setFixedCodec(m_features & FEATURE_FIXED_CODEC);
+                    federateAmbassadorChannel.setFixedCodec(m_features & FEATURE_FIXED_CODEC);
+                    ambassadorFederateChannel.setCompression(m_features & FEATURE_COMPRESSION);
+                    federateAmbassadorChannel.setCompression(m_features & FEATURE_COMPRESSION);
+                    NS_LOG_INFO("Negotiated protocol features " << m_features << " of requested " << init_message.features);
+                }
             } else {
                 ambassadorFederateChannel.writeCommand(CMD_END);
             }
@@ -86,10 +110,6 @@ namespace ns3 {
         std::cout << "ns3Server: created new connection to " << port << std::endl;
     }
 
-    void MosaicNs3Server::SetNumOfNodes(int numOfNodes){
-        m_numOfNodes = numOfNodes;
-    }
-
     /**
      * @brief NS3 Magic: a specialized entry-point is needed to create this class from a end-user script. The call of the constructor is forbidden by the NS3.
      * @brief this function is called by the starter script and obtains the whole simulation
@@ -100,21 +120,12 @@ namespace ns3 {
      */
     void MosaicNs3Server::processCommandsUntilSimStep() {
         try {
-            if (!m_closeConnection) {
-
-                Ptr<MosaicSimulatorImpl> Sim = DynamicCast<MosaicSimulatorImpl> (Simulator::GetImplementation());
-                Sim->AttachNS3Server(this);
-
-                //create the dummy event (end of the simulation) to avoid a empty event-list
-                //NS3 will throw an exception if the event-list is empty
-                Time tNext = NanoSeconds(m_endTime);
-                Simulator::Schedule(tNext, &MosaicNs3Server::Close, this);
-            } else {
+            if (m_closeConnection || !m_federate.Start(m_endTime)) {
                 return;
             }
 
-            while (!m_closeConnection) {
-                NS_LOG_INFO("NumberOfNodes= " << ns3::NodeList::GetNNodes());
+            while (!m_closeConnection && !m_federate.IsFinished()) {
+                MOSAIC_LOG_DEBUG("NumberOfNodes= {}", ns3::NodeList::GetNNodes());
                 dispatchCommand();
             }
 
@@ -134,29 +145,6 @@ namespace ns3 {
      */
     int MosaicNs3Server::dispatchCommand() {
 
-        //gets the pointer of the simulator
-        Ptr<MosaicSimulatorImpl> sim = DynamicCast<MosaicSimulatorImpl> (Simulator::GetImplementation());
-        if (nullptr == sim) {
-            NS_LOG_INFO("Could not find Mosaic simulator implementation \n");
-            m_closeConnection = true;
-            return 0;
-        }
-
-        if (m_commType == CommunicationType::DSRC){
-            if (!m_dsrc_init_complete){
-                m_nodeManager->InitDsrc();
-                m_dsrc_init_complete = true;
-            }
-        }else if (m_commType == CommunicationType::LTE){
-            if (!m_lte_init_complete){
-                m_nodeManager->InitLte(m_numOfNodes);
-                m_lte_init_complete = true;
-            }
-        }else{
-            NS_LOG_ERROR("Unknown communication type:" << m_commType);
-            return 0;
-        }
-
         //read the commandId from the channel
         CMD commandId = ambassadorFederateChannel.readCommand();
         switch (commandId) {
@@ -168,29 +156,26 @@ namespace ns3 {
             {
                 CSC_update_node_return update_node_message;
                 ambassadorFederateChannel.readUpdateNode(update_node_message);
-                Time tNext = NanoSeconds(update_node_message.time);
-                Time tDelay = tNext - sim->Now();
+                const uint64_t tNext = update_node_message.time;
                 for (std::vector<CSC_node_data>::iterator it = update_node_message.properties.begin(); it != update_node_message.properties.end(); ++it) {
 
                     if (update_node_message.type == UPDATE_ADD_RSU) {
-                        sim->Schedule(tDelay, MakeEvent(&MosaicNodeManager::CreateMosaicNode, m_nodeManager, it->id, Vector(it->x, it->y, 0.0)));
-                        NS_LOG_DEBUG("Received ADD_RSU: ID=" << it->id << " posx=" << it->x << " posy=" << it->y << " tNext=" << tNext);
+                        m_federate.AddNode(tNext, it->id, Vector(it->x, it->y, 0.0), true);
+                        MOSAIC_LOG_DEBUG("Received ADD_RSU: ID={} posx={} posy={} tNext={}", it->id, it->x, it->y, tNext);
 
                     } else if (update_node_message.type == UPDATE_ADD_VEHICLE) {
-                        sim->Schedule(tDelay, MakeEvent(&MosaicNodeManager::CreateMosaicNode, m_nodeManager, it->id, Vector(it->x, it->y, 0.0)));
-                        NS_LOG_DEBUG("Received ADD_VEHICLE: ID=" << it->id << " posx=" << it->x << " posy=" << it->y << " tNext=" << tNext);
+                        m_federate.AddNode(tNext, it->id, Vector(it->x, it->y, 0.0), false);
+                        MOSAIC_LOG_DEBUG("Received ADD_VEHICLE: ID={} posx={} posy={} tNext={}", it->id, it->x, it->y, tNext);
 
                     } else if (update_node_message.type == UPDATE_MOVE_NODE) {
-                        sim->Schedule(tDelay, MakeEvent(&MosaicNodeManager::UpdateNodePosition, m_nodeManager, it->id, Vector(it->x, it->y, 0.0)));
-                        NS_LOG_DEBUG("Received MOVE_NODES: ID=" << it->id << " posx=" << it->x << " posy=" << it->y << " tNext=" << tNext);
+                        m_federate.MoveNode(tNext, it->id, Vector(it->x, it->y, 0.0));
+                        MOSAIC_LOG_DEBUG("Received MOVE_NODES: ID={} posx={} posy={} tNext={}", it->id, it->x, it->y, tNext);
 
                     } else if (update_node_message.type == UPDATE_REMOVE_NODE) {
 
                         //It is not allowed to delete a node during the simulation step -> the node will be deactivated
-                        //void (std::vector<int>::*fctptr)(const int&) = &std::vector<int>::push_back;
-                        //sim->ScheduleAtTime(tNext, MakeEvent(fctptr, &m_deactivatedNodes, it->id));
-                        sim->Schedule(tDelay, MakeEvent(&MosaicNodeManager::DeactivateNode, m_nodeManager, it->id));
-                        NS_LOG_DEBUG("Received REMOVE_NODES: ID=" << it->id << " tNext=" << tNext);
+                        m_federate.RemoveNode(tNext, it->id);
+                        MOSAIC_LOG_DEBUG("Received REMOVE_NODES: ID={} tNext={}", it->id, tNext);
                     }
                 }
                 ambassadorFederateChannel.writeCommand(CMD_SUCCESS);
@@ -202,16 +187,19 @@ namespace ns3 {
                 uint64_t advancedTime;
                 advancedTime = ambassadorFederateChannel.readTimeMessage();
 
-                NS_LOG_DEBUG("Received ADVANCE_TIME " << advancedTime);
+                MOSAIC_LOG_DEBUG("Received ADVANCE_TIME {}", advancedTime);
                 //run the simulation (function RunSimStep) while the time of the next event is smaller than the next time step
                 m_eventSentUp = false;
-                while (!Simulator::IsFinished() && NanoSeconds(advancedTime) >= sim->Next().GetNanoSeconds()) {
-                    sim->RunOneEvent();
+                m_federate.AdvanceTime(advancedTime);
+
+                if (m_features & FEATURE_PIPELINED) {
+                    federateAmbassadorChannel.writePipelineAck(m_pipelinedCommands, m_failedCommands);
+                    m_pipelinedCommands = 0;
+                    m_failedCommands.clear();
                 }
 
                 //write the confirmation at the end of the sequence
-                federateAmbassadorChannel.writeCommand(CMD_END);
-                federateAmbassadorChannel.writeTimeMessage(Simulator::Now().GetNanoSeconds());
+                federateAmbassadorChannel.writeTimeCommand(CMD_END, m_federate.Now(), m_federate.GetLookahead(m_federate.Now()));
                 break;
 
             case CMD_CONF_RADIO:
@@ -220,8 +208,7 @@ namespace ns3 {
 
                     CSC_config_message config_message;
                     ambassadorFederateChannel.readConfigurationMessage(config_message);
-                    Time tNext = NanoSeconds(config_message.time);
-                    Time tDelay = tNext - sim->Now();
+                    m_pipelinedCommands++;
                     int transmitPower = -1;
                     bool radioTurnedOn = false;
                     if (config_message.num_radios == SINGLE_RADIO) {
@@ -229,7 +216,7 @@ namespace ns3 {
                         transmitPower = config_message.primary_radio.tx_power;
                     }
 
-                    sim->Schedule(tDelay, MakeEvent(&MosaicNodeManager::ConfigureNodeRadio, m_nodeManager, config_message.node_id, radioTurnedOn, transmitPower));
+                    m_federate.ConfigureRadio(config_message.time, config_message.node_id, radioTurnedOn, transmitPower, config_message.msg_id);
 
                 } catch (int e) {
                     NS_LOG_INFO("Error while reading configuration message \n");
@@ -237,30 +224,117 @@ namespace ns3 {
                 }
                 break;
 
+            case CMD_CONF_SIDELINK:
+            {
+                CSC_sidelink_config_message sidelink_message;
+                if (ambassadorFederateChannel.readSidelinkConfigurationMessage(sidelink_message) != 0) {
+                    NS_LOG_INFO("Error while reading sidelink configuration message \n");
+                    m_closeConnection = true;
+                    break;
+                }
+                m_pipelinedCommands++;
+                if (m_federate.GetCommType() != CommunicationType::LTE) {
+                    NS_LOG_WARN("Ignoring sidelink configuration, the federate does not simulate LTE");
+                    AnswerSidelinkConfiguration(sidelink_message, true);
+                    break;
+                }
+
+                // the preset is resolved when the change is applied, so pending changes build on each other
+                SidelinkUpdate update;
+                update.preset = sidelink_message.preset;
+                update.hasCarrierFreq = sidelink_message.has_carrier_freq;
+                update.carrierFreq = sidelink_message.carrier_freq;
+                update.hasSlBandwidth = sidelink_message.has_sl_bandwidth;
+                update.slBandwidth = sidelink_message.sl_bandwidth;
+                update.hasMessageId = sidelink_message.has_message_id;
+                update.messageId = sidelink_message.message_id;
+                for (const CSC_sidelink_pool &pool : sidelink_message.pools) {
+                    SidelinkPoolConfig poolConfig;
+                    poolConfig.slSubframe = pool.sl_subframe;
+                    poolConfig.adjacencyPscchPssch = pool.adjacency_pscch_pssch;
+                    poolConfig.sizeSubchannel = pool.size_subchannel;
+                    poolConfig.numSubchannel = pool.num_subchannel;
+                    poolConfig.startRbSubchannel = pool.start_rb_subchannel;
+                    poolConfig.startRbPscchPool = pool.start_rb_pscch_pool;
+                    poolConfig.dataTxP0 = pool.data_tx_p0;
+                    poolConfig.dataTxAlpha = pool.data_tx_alpha;
+                    if (pool.tx) {
+                        update.txPools.push_back(poolConfig);
+                    }
+                    if (pool.rx) {
+                        update.rxPools.push_back(poolConfig);
+                    }
+                }
+                // a pool list replaces both lists of the preset, one missing direction would fall back to the default pool
+                if (!sidelink_message.pools.empty() && (update.txPools.empty() || update.rxPools.empty())) {
+                    NS_LOG_ERROR("Rejecting sidelink configuration, the pool list needs at least one TX and one RX pool");
+                    AnswerSidelinkConfiguration(sidelink_message, false);
+                    break;
+                }
+                // the presets are fixed by the federate config, so an unknown name can be rejected before the ack
+                if (!update.preset.empty() && m_federate.GetNodeManager()->GetSidelinkPreset(update.preset) == nullptr) {
+                    NS_LOG_ERROR("Rejecting sidelink configuration, unknown preset " << update.preset);
+                    AnswerSidelinkConfiguration(sidelink_message, false);
+                    break;
+                }
+
+                m_federate.ConfigureSidelink(sidelink_message.time, update);
+                AnswerSidelinkConfiguration(sidelink_message, true);
+                NS_LOG_DEBUG("Received CONF_SIDELINK: preset=" << sidelink_message.preset << " pools=" << sidelink_message.pools.size());
+                break;
+            }
+
             case CMD_MSG_SEND:
             {
                 try {
                     CSC_send_message send_message;
                     ambassadorFederateChannel.readSendMessage(send_message);
+                    m_pipelinedCommands++;
                     //Convert the IP address
                     Ipv4Address ip(send_message.topo_address.ip_address);
-                    int id = m_nodeManager->GetNs3NodeId(send_message.node_id);
-                    NS_LOG_DEBUG("Received V2X_MESSAGE_TRANSMISSION id: " << id << " sendTime: " << send_message.time << " length: " << send_message.length);
+                    MOSAIC_LOG_DEBUG("Received V2X_MESSAGE_TRANSMISSION id: {} sendTime: {} length: {}",
+                            m_federate.GetNodeManager()->GetNs3NodeId(send_message.node_id), send_message.time, send_message.length);
 
                     //create a sending jitter to avoid concurrently sending
                     unsigned long long rando;
                     rando = (rand() % 100000000);
                     unsigned long long sendTime;
                     sendTime = send_message.time + rando;
-                    Time tNext = NanoSeconds(sendTime);
-                    Time tDelay = tNext - sim->Now();
 
-                    sim->Schedule(tDelay, MakeEvent(&MosaicNodeManager::SendMsg, m_nodeManager, send_message.node_id, 0, send_message.message_id, send_message.length, ip));
+                    m_federate.Send(sendTime, send_message.node_id, send_message.message_id, send_message.length, ip);
                 } catch (int e) {
                 }
                 break;
             }
+            case CMD_MSG_SEND_BATCH:
+            {
+                std::vector<CSC_send_message> send_messages;
+                if (ambassadorFederateChannel.readSendMessageBatch(send_messages) != 0) {
+                    NS_LOG_INFO("Error while reading send message batch \n");
+                    m_closeConnection = true;
+                    break;
+                }
+                m_pipelinedCommands += send_messages.size();
+
+                // the batch draws one sending jitter like a single MSG_SEND, so messages due at the same time still share one event
+                const unsigned long long rando = rand() % 100000000;
+                std::vector<MosaicSendRequest> batch;
+                size_t events = 0;
+                for (size_t i = 0; i < send_messages.size(); ++i) {
+                    const CSC_send_message &send_message = send_messages[i];
+                    batch.push_back({static_cast<uint32_t> (send_message.node_id), static_cast<uint32_t> (send_message.message_id),
+                        static_cast<uint32_t> (send_message.length), Ipv4Address(send_message.topo_address.ip_address)});
+                    if (i + 1 == send_messages.size() || send_messages[i + 1].time != send_message.time) {
+                        m_federate.SendBatch(send_message.time + rando, std::move(batch));
+                        batch.clear();
+                        events++;
+                    }
+                }
+                MOSAIC_LOG_DEBUG("Received MSG_SEND_BATCH with {} messages in {} events", send_messages.size(), events);
+                break;
+            }
             case CMD_SHUT_DOWN:
+                ReportCompressionStats();
                 m_closeConnection = true;
                 Simulator::Destroy();
                 break;
@@ -273,19 +347,49 @@ namespace ns3 {
         return commandId;
     }
 
-    void MosaicNs3Server::writeNextTime(unsigned long long nextTime) {
-        federateAmbassadorChannel.writeCommand(CMD_NEXT_EVENT);
-        federateAmbassadorChannel.writeTimeMessage(nextTime);
+    void MosaicNs3Server::ReportCompressionStats() {
+        if (!(m_features & FEATURE_COMPRESSION)) {
+            return;
+        }
+        const std::pair<const char*, ClientServerChannel*> channels[] = {
+            {"ambassador->federate", &ambassadorFederateChannel},
+            {"federate->ambassador", &federateAmbassadorChannel}
+        };
+        for (const auto &channel : channels) {
+            const CSC_compression_stats &stats = channel.second->getCompressionStats();
+            std::cout << "Compression " << channel.first << ": "
+                    << stats.frames_compressed << " frames compressed " << stats.raw_bytes_compressed << " -> " << stats.compressed_bytes_sent
+                    << " bytes in " << stats.compress_seconds << " s, "
+                    << stats.frames_decompressed << " frames decompressed " << stats.compressed_bytes_received << " -> " << stats.raw_bytes_decompressed
+                    << " bytes in " << stats.decompress_seconds << " s";
+            const uint64_t compressed = stats.compressed_bytes_sent + stats.compressed_bytes_received;
+            if (compressed > 0) {
+                std::cout << ", ratio " << static_cast<double> (stats.raw_bytes_compressed + stats.raw_bytes_decompressed) / compressed;
+            }
+            std::cout << std::endl;
+        }
     }
 
-    bool MosaicNs3Server::AddRecvPacket(unsigned long long recvTime, Ptr<Packet> pack, int nodeID, int msgID) {
-        federateAmbassadorChannel.writeCommand(CMD_MSG_RECV);
-        federateAmbassadorChannel.writeReceiveMessage(recvTime, nodeID, msgID, CCH, 0);
-        m_eventSentUp = true;
-        return true;
+    void MosaicNs3Server::AnswerSidelinkConfiguration(const CSC_sidelink_config_message &message, bool accepted) {
+        if (!(m_features & FEATURE_PIPELINED)) {
+            ambassadorFederateChannel.writeCommand(accepted ? CMD_SUCCESS : CMD_ERROR);
+        } else if (!accepted && message.has_message_id) {
+            m_failedCommands.push_back(message.message_id);
+        }
     }
 
-    void MosaicNs3Server::Close() {
-        m_closeConnection = true;
+    void MosaicNs3Server::ReportCommandError(uint32_t msgID) {
+        if (m_features & FEATURE_PIPELINED) {
+            m_failedCommands.push_back(msgID);
+        }
+    }
+
+    void MosaicNs3Server::writeNextTime(unsigned long long nextTime) {
+        federateAmbassadorChannel.writeTimeCommand(CMD_NEXT_EVENT, nextTime, m_federate.GetLookahead(nextTime));
+    }
+
+    void MosaicNs3Server::AddRecvPacket(unsigned long long recvTime, int nodeID, int msgID) {
+        federateAmbassadorChannel.writeReceiveCommand(recvTime, nodeID, msgID, CCH, 0);
+        m_eventSentUp = true;
     }
 } //END Namespace
@@ -24,7 +24,7 @@
 #define MOSAIC_NS3_SERVER_H
 
 #include "ClientServerChannel.h"
-#include "mosaic-node-manager.h"
+#include "mosaic-federate.h"
 #include "ns3/point-to-point-epc-helper.h"
 #include <atomic>
 
@@ -32,14 +32,13 @@ namespace ns3 {
     using namespace ClientServerChannelSpace;
 
     /**
-     * @brief The central class of the MOSAIC-NS3 coupling
+     * @brief The central class of the MOSAIC-NS3 coupling, maps the commands of the
+     * MOSAIC ambassador onto the in-process MosaicFederate and reports its events back
      */
     class MosaicNs3Server {
     public:
         MosaicNs3Server() = delete;
-        MosaicNs3Server(int port, int cmdPort, std::string commType = "LTE");
-
-        void SetNumOfNodes(int numOfNodes);
+        MosaicNs3Server(int port, int cmdPort, const FederateConfig &config);
 
         /**
          * @brief NS3 Magic: a specialized entry-point is needed to create this class from a end-user script. The call of the constructor is forbidden by the NS3.
@@ -51,15 +50,16 @@ namespace ns3 {
          */
         void processCommandsUntilSimStep();
 
+    private:
+
         /**
-         * @brief add a packet to the receive-list
+         * @brief report a received message to the ambassador
          *
          * @param recvTime  time of the receipt
-         * @param pack  pointer of the packet
          * @param nodeID    id of the node
          * @param msgID the id of the message
          */
-        bool AddRecvPacket(unsigned long long recvTime, Ptr<Packet> pack, int nodeID, int msgID);
+        void AddRecvPacket(unsigned long long recvTime, int nodeID, int msgID);
 
         /**
          * @brief write the next Time to the channel
@@ -67,7 +67,13 @@ namespace ns3 {
          */
         void writeNextTime(unsigned long long nextTime);
 
-    private:
+        /**
+         * @brief note a MSG_SEND, CONF_RADIO or CONF_SIDELINK command which could not be executed,
+         * reported to the ambassador with the next pipeline ack
+         *
+         * @param msgID the message id of the failed command
+         */
+        void ReportCommandError(uint32_t msgID);
 
         /**
          * @brief This function dispatch all commands from MOSAIC and sends the results back the the framework
@@ -118,7 +124,15 @@ namespace ns3 {
          */
         void CreateNode(int ID, int posx, int posy);
 
-        void Close();
+        /**
+         * @brief print ratio and codec time of the frame compression, if it was negotiated
+         */
+        void ReportCompressionStats();
+
+        /**
+         * @brief answer a sidelink configuration with SUCCESS or ERROR, or with the next pipeline ack if pipelined
+         */
+        void AnswerSidelinkConfiguration(const CSC_sidelink_config_message &message, bool accepted);
 
         void DeactivateNode(uint32_t nodeId);
         
@@ -129,14 +143,12 @@ namespace ns3 {
         std::vector<int> m_deactivatedNodes;        
         std::atomic_bool m_closeConnection;
         bool m_eventSentUp = false;
-        Ptr<MosaicNodeManager> m_nodeManager;
-
-        CommunicationType m_commType;
-
-        int m_numOfNodes = 5;
-
-        bool m_lte_init_complete = false;
-        bool m_dsrc_init_complete = false;
+        // protocol features negotiated at CMD_INIT, bitmask of FEATURE
+        uint32_t m_features = FEATURE_NONE;
+        // pipelined commands read and failed since the last pipeline ack
+        uint32_t m_pipelinedCommands = 0;
+        std::vector<uint32_t> m_failedCommands;
+        MosaicFederate m_federate;
     };
 }
 #endif
@@ -27,6 +27,7 @@
 #include "ns3/flow-id-tag.h"
 #include "ns3/udp-socket-factory.h"
 #include "ns3/log.h"
+#include "mosaic-logger.h"
 
 NS_LOG_COMPONENT_DEFINE("MosaicProxyApp");
 
@@ -54,6 +55,7 @@ namespace ns3 {
     void MosaicProxyApp::DoDispose(void) {
         NS_LOG_FUNCTION_NOARGS();
         m_rxSocket = 0;
+        m_txSocket = 0;
         Application::DoDispose();
     }
 
@@ -99,11 +101,33 @@ namespace ns3 {
         }
     }
 
+    void MosaicProxyApp::CloseSockets(void) {
+        NS_LOG_FUNCTION_NOARGS();
+        if (m_rxSocket) {
+            m_rxSocket->SetRecvCallback(MakeNullCallback<void, Ptr<Socket> > ());
+            m_rxSocket->Close();
+            m_rxSocket = 0;
+        }
+        if (m_txSocket) {
+            m_txSocket->Close();
+            m_txSocket = 0;
+        }
+    }
+
+    void MosaicProxyApp::StopApplication(void) {
+        Disable();
+        CloseSockets();
+    }
+
     void MosaicProxyApp::TransmitPacket(uint32_t protocolID, uint32_t msgID, uint32_t payLength, Ipv4Address address) {
         NS_LOG_FUNCTION(protocolID << msgID << payLength << address);
         if (!m_active) {
             return;
         }
+        if ((m_commType == DSRC && !m_rxSocket) || (m_commType == LTE && !m_txSocket)) {
+            NS_LOG_ERROR("Node " << GetNode()->GetId() << " has no open socket, can not send message " << msgID);
+            return;
+        }
 
         Ptr<Packet> packet = Create<Packet> (payLength);
         //Flow tag is used to match the sent message
@@ -112,7 +136,7 @@ namespace ns3 {
         packet->AddByteTag(msgIDTag);
 
         m_sendCount++;
-        NS_LOG_INFO("Node " << GetNode()->GetId() << " SENDING packet no. " << m_sendCount << " PacketID= " << packet->GetUid() << " at " << Simulator::Now().GetNanoSeconds() << " seconds | packet size = " << packet->GetSize());
+        MOSAIC_LOG_DEBUG("Node {} SENDING packet no. {} PacketID= {} at {} ns | packet size = {}", GetNode()->GetId(), m_sendCount, packet->GetUid(), Simulator::Now().GetNanoSeconds(), packet->GetSize());
         
         //call the socket of this node to send the packet
         if (m_commType == DSRC){
@@ -129,15 +153,12 @@ namespace ns3 {
      * This method is called by the callback which is defined in the method MosaicProxyApp::SetSockets
      */
     void MosaicProxyApp::Receive(Ptr<Socket> socket) {
-        NS_LOG_INFO("FEDERATE DEBUG: Receive Packet" );
-        std::cout << "FEDERATE DEBUG: Receive Packet" << std::endl;
         NS_LOG_FUNCTION_NOARGS();
         if (!m_active) {
             return;
         }
 
         Ptr<Packet> packet;
-        NS_LOG_INFO("Start Receiving - Call Socket -> Recv()");
         packet = socket->Recv();
 
         // m_recvCount++;
@@ -154,9 +175,8 @@ namespace ns3 {
             msgID = -1;
         }
 
-        //report the received messages to the MosaicNs3Server instance
+        //report the received messages to the MosaicFederate instance
         m_nodeManager->AddRecvPacket(Simulator::Now().GetNanoSeconds(), packet, GetNode()->GetId(), msgID);
-        NS_LOG_INFO("Receiving message no. " << m_recvCount << " PacketID= " << packet->GetUid() << " at " << Simulator::Now().GetNanoSeconds() << " seconds | message size  = " << packet->GetSize() << " Bytes");
-        NS_LOG_INFO("Reception on node " << GetNode()->GetId());
+        MOSAIC_LOG_DEBUG("Node {} received message {} PacketID= {} at {} ns | message size = {} Bytes", GetNode()->GetId(), msgID, packet->GetUid(), Simulator::Now().GetNanoSeconds(), packet->GetSize());
     }
 } // namespace ns3
@@ -50,6 +50,11 @@ namespace ns3 {
         void SetTxSocket(void);
 
         void SetRxSocket(void);
+
+        /**
+         * @brief close and release the sockets of this app, the app will neither send nor receive afterwards
+         */
+        void CloseSockets(void);
         
         void TransmitPacket(uint32_t protocolID, uint32_t msgID, uint32_t payLength, Ipv4Address address);
         
@@ -62,7 +67,9 @@ namespace ns3 {
         uint16_t m_port = 0;
 
     private:
-        
+
+        virtual void StopApplication(void);
+
         void Receive(Ptr<Socket> socket);
 
         Ptr<Socket> m_txSocket{nullptr};
@@ -21,6 +21,7 @@
  */
 
 #include "mosaic-simulator-impl.h"
+#include "mosaic-federate.h"
 #include "ns3/simulator.h"
 #include "ns3/event-impl.h"
 #include "ns3/ptr.h"
@@ -53,6 +54,7 @@ namespace ns3 {
         m_currentTs = 0;
         m_currentContext = 0xffffffff;
         m_unscheduledEvents = 0;
+        m_federate = nullptr;
     }
 
     void MosaicSimulatorImpl::DoDispose(void) {
@@ -87,8 +89,16 @@ namespace ns3 {
         m_events = scheduler;
     }
 
-    // System ID for non-distributed simulation is always zero
+    uint64_t MosaicSimulatorImpl::GetEventCount(void) const {
+        // uids 0 to 3 are reserved
+        return m_uid - 4;
+    }
 
+    // System ID for non-distributed simulation is always zero.
+    // The federate is not distributed: ns-3 MPI only connects ranks through point-to-point
+    // links, the wifi and LTE spectrum channels can not span ranks and a node can not move
+    // to another rank after its creation, so radio transmissions across region borders and
+    // node migration following UpdateNodePosition are not possible with it.
     uint32_t MosaicSimulatorImpl::GetSystemId(void) const {
         return 0;
     }
@@ -157,7 +167,9 @@ namespace ns3 {
         m_uid++;
         m_unscheduledEvents++;
         m_events->Insert(ev);
-        m_server->writeNextTime(ev.key.m_ts);
+        if (m_federate != nullptr) {
+            m_federate->NotifyNextEvent(ev.key.m_ts);
+        }
 
         return EventId(event, ev.key.m_ts, ev.key.m_context, ev.key.m_uid);
     }
@@ -173,7 +185,9 @@ namespace ns3 {
         m_uid++;
         m_unscheduledEvents++;
         m_events->Insert(ev);
-        m_server->writeNextTime(ev.key.m_ts);
+        if (m_federate != nullptr) {
+            m_federate->NotifyNextEvent(ev.key.m_ts);
+        }
     }
 
     EventId MosaicSimulatorImpl::ScheduleNow(EventImpl *event) {
@@ -286,12 +300,12 @@ namespace ns3 {
     }
 
     /**
-     * @brief Attach the instance of the MOSAIC server to the object of this class
+     * @brief Attach the federate which is notified about every scheduled event
      * 
-     * @param the MOSAIC server instance
+     * @param federate the federate instance, nullptr to detach
      */
-    void MosaicSimulatorImpl::AttachNS3Server(MosaicNs3Server* server) {
-        m_server = server;
+    void MosaicSimulatorImpl::AttachFederate(MosaicFederate* federate) {
+        m_federate = federate;
     }
 
 } // namespace ns3
@@ -24,7 +24,6 @@
 #define MOSAIC_SIMULATOR_IMPL_H
 
 #include "ns3/simulator-impl.h"
-#include "mosaic-ns3-server.h"
 #include "ns3/scheduler.h"
 #include "ns3/event-impl.h"
 #include "ns3/ptr.h"
@@ -33,15 +32,26 @@
 
 namespace ns3 {
 
+    class MosaicFederate;
+
     /**
      * @class MosaicSimulatorImpl
      * @brief the MOSAIC simulator implementation extends the NS3 standard simulator 
-     * implementation with the methods AttachNS3Server and RunOneEvent.
+     * implementation with the methods AttachFederate and RunOneEvent.
      * Unfortunately, the default simulator, provided by ns-3 does not allow to use the
      * processOneEvent() function. Hence we need to copy this class and provide the function
      * here. The Event class, providing a global static interface can not call
      * processOneEvent() either, so in the MOSAIC server, we need to obtain a direct pointer
-     * to this instance and call it directly.
+     * to this instance and call it directly. Every scheduled event is announced to the
+     * attached MosaicFederate.
+     *
+     * Events are executed one by one, also for different contexts. The ns-3 objects the
+     * events operate on are not thread safe: Ptr reference counts are not atomic, packet
+     * uids come from one global counter, the random streams and the wifi/spectrum channels
+     * are shared by all nodes and events schedule new events into the same queue. Running
+     * events of different contexts concurrently would neither be safe nor reproduce the
+     * serial results. The CPU bound part of dense DSRC scenarios, the per receiver
+     * propagation evaluation, is parallelized inside MosaicWifiChannel instead.
      */
     class MosaicSimulatorImpl : public SimulatorImpl {
     public:
@@ -51,7 +61,12 @@ namespace ns3 {
 
         static TypeId GetTypeId(void);
 
-        void AttachNS3Server(MosaicNs3Server* instance);
+        void AttachFederate(MosaicFederate* federate);
+
+        /**
+         * @brief number of events scheduled since the simulator was created, including the cancelled ones
+         */
+        uint64_t GetEventCount(void) const;
         
         virtual EventId Schedule(Time const &time, EventImpl *event);
         virtual void Destroy();
@@ -92,7 +107,7 @@ namespace ns3 {
         // number of events that have been inserted but not yet scheduled,
         // not counting the "destroy" events; this is used for validation
         int m_unscheduledEvents;
-        MosaicNs3Server* m_server;
+        MosaicFederate* m_federate;
 
     };
 } // namespace ns3
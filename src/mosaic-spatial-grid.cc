@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) 2020 Fraunhofer FOKUS and others. All rights reserved.
+ *
+ * Contact: mosaic@fokus.fraunhofer.de
+ *
+ * This class is developed for the MOSAIC-NS-3 coupling.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "mosaic-spatial-grid.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "ns3/assert.h"
+
+namespace ns3 {
+
+    MosaicSpatialGrid::MosaicSpatialGrid(double cellSize) : m_cellSize(cellSize) {
+        NS_ASSERT(cellSize > 0);
+    }
+
+    void MosaicSpatialGrid::SetCellSize(double cellSize) {
+        NS_ASSERT(cellSize > 0);
+        if (cellSize == m_cellSize) {
+            return;
+        }
+        m_cellSize = cellSize;
+        m_cells.clear();
+        for (auto &it : m_entries) {
+            it.second.cell = GetCellKey(GetCellIndex(it.second.position.x), GetCellIndex(it.second.position.y));
+            InsertIntoCell(it.first, it.second.cell);
+        }
+    }
+
+    double MosaicSpatialGrid::GetCellSize(void) const {
+        return m_cellSize;
+    }
+
+    void MosaicSpatialGrid::Update(uint32_t id, const Vector &position) {
+        CellKey cell = GetCellKey(GetCellIndex(position.x), GetCellIndex(position.y));
+        auto it = m_entries.find(id);
+        if (it == m_entries.end()) {
+            m_entries[id] = Entry{position, cell};
+            InsertIntoCell(id, cell);
+            return;
+        }
+        if (it->second.cell != cell) {
+            RemoveFromCell(id, it->second.cell);
+            InsertIntoCell(id, cell);
+            it->second.cell = cell;
+        }
+        it->second.position = position;
+    }
+
+    void MosaicSpatialGrid::Remove(uint32_t id) {
+        auto it = m_entries.find(id);
+        if (it == m_entries.end()) {
+            return;
+        }
+        RemoveFromCell(id, it->second.cell);
+        m_entries.erase(it);
+    }
+
+    bool MosaicSpatialGrid::Contains(uint32_t id) const {
+        return m_entries.find(id) != m_entries.end();
+    }
+
+    const Vector &MosaicSpatialGrid::GetPosition(uint32_t id) const {
+        return m_entries.at(id).position;
+    }
+
+    std::size_t MosaicSpatialGrid::GetN(void) const {
+        return m_entries.size();
+    }
+
+    void MosaicSpatialGrid::Query(const Vector &center, double range, std::vector<uint32_t> &result) const {
+        result.clear();
+        if (range <= 0) {
+            result.reserve(m_entries.size());
+            for (const auto &it : m_entries) {
+                result.push_back(it.first);
+            }
+            std::sort(result.begin(), result.end());
+            return;
+        }
+
+        const int64_t minX = GetCellIndex(center.x - range);
+        const int64_t maxX = GetCellIndex(center.x + range);
+        const int64_t minY = GetCellIndex(center.y - range);
+        const int64_t maxY = GetCellIndex(center.y + range);
+        const double rangeSquared = range * range;
+
+        for (int64_t cellX = minX; cellX <= maxX; cellX++) {
+            for (int64_t cellY = minY; cellY <= maxY; cellY++) {
+                auto cell = m_cells.find(GetCellKey(cellX, cellY));
+                if (cell == m_cells.end()) {
+                    continue;
+                }
+                for (uint32_t id : cell->second) {
+                    const Vector &position = m_entries.at(id).position;
+                    const double dx = position.x - center.x;
+                    const double dy = position.y - center.y;
+                    const double dz = position.z - center.z;
+                    if (dx * dx + dy * dy + dz * dz <= rangeSquared) {
+                        result.push_back(id);
+                    }
+                }
+            }
+        }
+        std::sort(result.begin(), result.end());
+    }
+
+    int64_t MosaicSpatialGrid::GetCellIndex(double coordinate) const {
+        return static_cast<int64_t> (std::floor(coordinate / m_cellSize));
+    }
+
+    MosaicSpatialGrid::CellKey MosaicSpatialGrid::GetCellKey(int64_t cellX, int64_t cellY) {
+        return (static_cast<CellKey> (cellX) << 32) ^ static_cast<uint32_t> (cellY);
+    }
+
+    void MosaicSpatialGrid::InsertIntoCell(uint32_t id, CellKey cell) {
+        m_cells[cell].push_back(id);
+    }
+
+    void MosaicSpatialGrid::RemoveFromCell(uint32_t id, CellKey cell) {
+        auto it = m_cells.find(cell);
+        if (it == m_cells.end()) {
+            return;
+        }
+        std::vector<uint32_t> &ids = it->second;
+        auto pos = std::find(ids.begin(), ids.end(), id);
+        if (pos != ids.end()) {
+            *pos = ids.back();
+            ids.pop_back();
+        }
+        if (ids.empty()) {
+            m_cells.erase(it);
+        }
+    }
+}
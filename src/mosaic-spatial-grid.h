@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) 2020 Fraunhofer FOKUS and others. All rights reserved.
+ *
+ * Contact: mosaic@fokus.fraunhofer.de
+ *
+ * This class is developed for the MOSAIC-NS-3 coupling.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef MOSAIC_SPATIAL_GRID_H
+#define MOSAIC_SPATIAL_GRID_H
+
+#include <unordered_map>
+#include <vector>
+
+#include "ns3/vector.h"
+
+namespace ns3 {
+
+    /**
+     * @class MosaicSpatialGrid
+     * @brief Uniform grid over the x/y plane which indexes node positions by id.
+     * Range queries only visit the cells overlapping the query circle, so the cost
+     * of a query depends on the local node density instead of the total node count.
+     */
+    class MosaicSpatialGrid {
+    public:
+        explicit MosaicSpatialGrid(double cellSize = 250.0);
+
+        /**
+         * @brief set the edge length of a grid cell and re-index all entries
+         *
+         * @param cellSize edge length in meters, must be positive
+         */
+        void SetCellSize(double cellSize);
+
+        double GetCellSize(void) const;
+
+        /**
+         * @brief insert the entry or move it to the given position
+         *
+         * @param id id of the entry
+         * @param position the new position
+         */
+        void Update(uint32_t id, const Vector &position);
+
+        void Remove(uint32_t id);
+
+        bool Contains(uint32_t id) const;
+
+        /**
+         * @brief the position of an entry, it must be contained
+         */
+        const Vector &GetPosition(uint32_t id) const;
+
+        std::size_t GetN(void) const;
+
+        /**
+         * @brief collect the ids of all entries within range of the given center
+         *
+         * The result is sorted ascending by id, so callers iterating it get a
+         * deterministic order. A non-positive range returns all entries.
+         *
+         * @param center center of the query circle
+         * @param range radius of the query circle in meters
+         * @param result vector which is cleared and filled with the matching ids
+         */
+        void Query(const Vector &center, double range, std::vector<uint32_t> &result) const;
+
+    private:
+        typedef int64_t CellKey;
+
+        struct Entry {
+            Vector position;
+            CellKey cell;
+        };
+
+        int64_t GetCellIndex(double coordinate) const;
+        static CellKey GetCellKey(int64_t cellX, int64_t cellY);
+
+        void InsertIntoCell(uint32_t id, CellKey cell);
+        void RemoveFromCell(uint32_t id, CellKey cell);
+
+        double m_cellSize;
+        std::unordered_map<uint32_t, Entry> m_entries;
+        std::unordered_map<CellKey, std::vector<uint32_t>> m_cells;
+    };
+}
+#endif
@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2020 Fraunhofer FOKUS and others. All rights reserved.
+ *
+ * Contact: mosaic@fokus.fraunhofer.de
+ *
+ * This class is developed for the MOSAIC-NS-3 coupling.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "mosaic-thread-pool.h"
+
+#include <algorithm>
+
+namespace ns3 {
+
+    MosaicThreadPool::MosaicThreadPool(unsigned int numThreads) {
+        if (numThreads == 0) {
+            numThreads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        // the calling thread works on a chunk as well
+        for (unsigned int i = 1; i < numThreads; i++) {
+            m_workers.emplace_back(&MosaicThreadPool::WorkerLoop, this);
+        }
+    }
+
+    MosaicThreadPool::~MosaicThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_shutdown = true;
+        }
+        m_wakeUp.notify_all();
+        for (std::thread &worker : m_workers) {
+            worker.join();
+        }
+    }
+
+    unsigned int MosaicThreadPool::GetNThreads(void) const {
+        return m_workers.size() + 1;
+    }
+
+    void MosaicThreadPool::ParallelFor(std::size_t count, const std::function<void(std::size_t, std::size_t)> &function) {
+        if (count == 0) {
+            return;
+        }
+        const std::size_t chunkSize = (count + GetNThreads() - 1) / GetNThreads();
+        const std::size_t numChunks = (count + chunkSize - 1) / chunkSize;
+        if (numChunks == 1) {
+            function(0, count);
+            return;
+        }
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_function = &function;
+        m_count = count;
+        m_chunkSize = chunkSize;
+        m_numChunks = numChunks;
+        m_nextChunk = 0;
+        m_pendingChunks = numChunks;
+        m_generation++;
+        m_wakeUp.notify_all();
+
+        // take part in the work until no chunk is left, then wait for the workers
+        while (m_nextChunk < numChunks) {
+            const std::size_t begin = m_nextChunk * m_chunkSize;
+            m_nextChunk++;
+            lock.unlock();
+            function(begin, std::min(begin + m_chunkSize, count));
+            lock.lock();
+            m_pendingChunks--;
+        }
+        m_done.wait(lock, [this] { return m_pendingChunks == 0; });
+        m_function = nullptr;
+    }
+
+    void MosaicThreadPool::WorkerLoop(void) {
+        uint64_t seenGeneration = 0;
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (true) {
+            m_wakeUp.wait(lock, [this, &seenGeneration] { return m_shutdown || m_generation != seenGeneration; });
+            if (m_shutdown) {
+                return;
+            }
+            seenGeneration = m_generation;
+            while (m_function != nullptr && m_nextChunk < m_numChunks) {
+                const std::size_t begin = m_nextChunk * m_chunkSize;
+                m_nextChunk++;
+                const std::function<void(std::size_t, std::size_t)> &function = *m_function;
+                const std::size_t end = std::min(begin + m_chunkSize, m_count);
+                lock.unlock();
+                function(begin, end);
+                lock.lock();
+                if (--m_pendingChunks == 0) {
+                    m_done.notify_all();
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2020 Fraunhofer FOKUS and others. All rights reserved.
+ *
+ * Contact: mosaic@fokus.fraunhofer.de
+ *
+ * This class is developed for the MOSAIC-NS-3 coupling.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef MOSAIC_THREAD_POOL_H
+#define MOSAIC_THREAD_POOL_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ns3 {
+
+    /**
+     * @class MosaicThreadPool
+     * @brief Fixed set of worker threads to split pure computations over index ranges.
+     * The tasks must not touch ns-3 objects (no Ptr copies, no scheduling), they only
+     * read and write plain arrays. Each index is processed exactly once, hence results
+     * do not depend on the number of threads or on the thread timing.
+     */
+    class MosaicThreadPool {
+    public:
+        /**
+         * @param numThreads number of worker threads, 0 uses the hardware concurrency
+         */
+        explicit MosaicThreadPool(unsigned int numThreads = 0);
+        ~MosaicThreadPool();
+
+        MosaicThreadPool(const MosaicThreadPool &) = delete;
+        MosaicThreadPool &operator=(const MosaicThreadPool &) = delete;
+
+        unsigned int GetNThreads(void) const;
+
+        /**
+         * @brief call the function for consecutive chunks of [0, count) and block until all chunks are done
+         *
+         * The calling thread processes one of the chunks itself.
+         *
+         * @param count number of indices
+         * @param function called with the half-open index range [begin, end) of a chunk
+         */
+        void ParallelFor(std::size_t count, const std::function<void(std::size_t begin, std::size_t end)> &function);
+
+    private:
+        void WorkerLoop(void);
+
+        std::vector<std::thread> m_workers;
+        std::mutex m_mutex;
+        std::condition_variable m_wakeUp;
+        std::condition_variable m_done;
+
+        const std::function<void(std::size_t, std::size_t)> *m_function = nullptr;
+        std::size_t m_count = 0;
+        std::size_t m_chunkSize = 0;
+        std::size_t m_numChunks = 0;
+        std::size_t m_nextChunk = 0;
+        std::size_t m_pendingChunks = 0;
+        uint64_t m_generation = 0;
+        bool m_shutdown = false;
+    };
+}
+#endif
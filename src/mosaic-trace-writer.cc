@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2020 Fraunhofer FOKUS and others. All rights reserved.
+ *
+ * Contact: mosaic@fokus.fraunhofer.de
+ *
+ * This class is developed for the MOSAIC-NS-3 coupling.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+
+#include "mosaic-trace-writer.h"
+
+#include <algorithm>
+
+namespace ns3 {
+
+    static const char MAGIC[8] = {'M', 'O', 'S', 'T', 'R', 'A', 'C', 'E'};
+    static const uint32_t VERSION = 1;
+    static const uint8_t TABLE_RECORD = 1;
+    static const uint8_t BLOCK_RECORD = 2;
+
+    MosaicTraceWriter::MosaicTraceWriter(const std::string &fileName, uint32_t blockRows, double flushInterval) :
+    m_fileBuffer(1 << 20), m_blockRows(std::max(1u, blockRows)),
+    m_flushInterval(std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(flushInterval))) {
+        // the buffer must be set before the file is opened
+        m_out.rdbuf()->pubsetbuf(m_fileBuffer.data(), m_fileBuffer.size());
+        m_out.open(fileName, std::ios::binary | std::ios::trunc);
+        m_out.write(MAGIC, sizeof(MAGIC));
+        Write<uint32_t>(VERSION);
+        m_nextFlush = std::chrono::steady_clock::now() + m_flushInterval;
+    }
+
+    MosaicTraceWriter::~MosaicTraceWriter() {
+        Flush();
+    }
+
+    bool MosaicTraceWriter::IsOpen(void) const {
+        return m_out.is_open() && m_out.good();
+    }
+
+    uint16_t MosaicTraceWriter::AddTable(const std::string &name, const std::vector<Column> &columns) {
+        Table table;
+        table.id = m_tables.size();
+        table.name = name;
+        table.columns.resize(columns.size());
+
+        Write<uint8_t>(TABLE_RECORD);
+        Write<uint16_t>(table.id);
+        WriteString(name);
+        Write<uint16_t>(columns.size());
+        for (std::size_t i = 0; i < columns.size(); i++) {
+            table.types.push_back(columns[i].type);
+            table.columns[i].reserve(m_blockRows * GetSize(columns[i].type));
+            Write<uint8_t>(columns[i].type);
+            WriteString(columns[i].name);
+        }
+        m_tables.push_back(std::move(table));
+        return m_tables.back().id;
+    }
+
+    void MosaicTraceWriter::Flush(void) {
+        for (Table &table : m_tables) {
+            WriteBlock(table);
+        }
+        m_out.flush();
+        m_nextFlush = std::chrono::steady_clock::now() + m_flushInterval;
+    }
+
+    std::size_t MosaicTraceWriter::GetSize(ColumnType type) {
+        switch (type) {
+            case UINT8:
+                return 1;
+            case UINT16:
+                return 2;
+            case UINT32:
+                return 4;
+            default:
+                return 8;
+        }
+    }
+
+    void MosaicTraceWriter::WriteBlock(Table &table) {
+        if (table.rows == 0) {
+            return;
+        }
+        Write<uint8_t>(BLOCK_RECORD);
+        Write<uint16_t>(table.id);
+        Write<uint32_t>(table.rows);
+        for (std::vector<char> &column : table.columns) {
+            m_out.write(column.data(), column.size());
+            column.clear();
+        }
+        table.rows = 0;
+    }
+
+    void MosaicTraceWriter::WriteString(const std::string &value) {
+        const uint16_t length = std::min<std::size_t>(value.size(), UINT16_MAX);
+        Write<uint16_t>(length);
+        m_out.write(value.data(), length);
+    }
+}
@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) 2020 Fraunhofer FOKUS and others. All rights reserved.
+ *
+ * Contact: mosaic@fokus.fraunhofer.de
+ *
+ * This class is developed for the MOSAIC-NS-3 coupling.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+
+#ifndef MOSAIC_TRACE_WRITER_H
+#define MOSAIC_TRACE_WRITER_H
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "ns3/assert.h"
+#include "ClientServerChannelFixedCodec.h"
+
+namespace ns3 {
+
+    /**
+     * @class MosaicTraceWriter
+     * @brief Buffered binary writer for trace records, organized as tables with typed columns.
+     *
+     * Rows are collected column by column and written as one block per table once
+     * BlockRows rows are buffered. Partial blocks are written and the stream is flushed
+     * when the flush interval (wall clock) has passed and when the writer is destroyed.
+     * The file is never synced, the operating system decides when the data hits the disk.
+     *
+     * File layout, all integers little-endian:
+     *   header:  "MOSTRACE", uint32 version
+     *   table:   uint8 1, uint16 table id, string name, uint16 column count,
+     *            per column: uint8 type, string name
+     *   block:   uint8 2, uint16 table id, uint32 row count,
+     *            per column: row count values of the column type
+     * Strings are written as uint16 length and the characters. Every table is defined
+     * before its first block.
+     */
+    class MosaicTraceWriter {
+    public:
+        enum ColumnType : uint8_t {
+            UINT8 = 1,
+            UINT16 = 2,
+            UINT32 = 3,
+            UINT64 = 4,
+            INT64 = 5,
+            DOUBLE = 6
+        };
+
+        struct Column {
+            std::string name;
+            ColumnType type;
+        };
+
+        /**
+         * @param fileName the file to write, it is truncated
+         * @param blockRows number of rows buffered per table before a block is written
+         * @param flushInterval wall clock seconds between flushes of the partial blocks
+         */
+        MosaicTraceWriter(const std::string &fileName, uint32_t blockRows, double flushInterval);
+        ~MosaicTraceWriter();
+
+        MosaicTraceWriter(const MosaicTraceWriter &) = delete;
+        MosaicTraceWriter &operator=(const MosaicTraceWriter &) = delete;
+
+        bool IsOpen(void) const;
+
+        /**
+         * @brief define a table
+         *
+         * @return the id to pass to Append
+         */
+        uint16_t AddTable(const std::string &name, const std::vector<Column> &columns);
+
+        /**
+         * @brief add one row, the values must have the types of the columns in their order
+         */
+        template <typename... T>
+        void Append(uint16_t tableId, T... values) {
+            NS_ASSERT(tableId < m_tables.size());
+            Table &table = m_tables[tableId];
+            NS_ASSERT_MSG(sizeof...(T) == table.columns.size(), "Wrong number of values for table " << table.name);
+            std::size_t column = 0;
+            int expand[] = {0, (Put(table, column++, values), 0)...};
+            (void) expand;
+            if (++table.rows == m_blockRows) {
+                WriteBlock(table);
+            }
+            // looking at the clock for every row would cost more than the row itself
+            if ((++m_appends & 0x3F) == 0 && std::chrono::steady_clock::now() >= m_nextFlush) {
+                Flush();
+            }
+        }
+
+        /**
+         * @brief write the partial blocks of all tables and flush the stream
+         */
+        void Flush(void);
+
+    private:
+        struct Table {
+            uint16_t id;
+            std::string name;
+            std::vector<ColumnType> types;
+            std::vector<std::vector<char>> columns;
+            uint32_t rows = 0;
+        };
+
+        static std::size_t GetSize(ColumnType type);
+
+        template <typename T>
+        void Put(Table &table, std::size_t column, T value) {
+            NS_ASSERT_MSG(sizeof(T) == GetSize(table.types[column]), "Wrong type for column " << column << " of table " << table.name);
+            std::vector<char> &data = table.columns[column];
+            const std::size_t offset = data.size();
+            data.resize(offset + sizeof(T));
+            Store(data.data(), offset, value);
+        }
+
+        template <typename T>
+        static void Store(char *buffer, std::size_t offset, T value) {
+            ClientServerChannelSpace::FixedCodec::store<T>(buffer, offset, value);
+        }
+
+        static void Store(char *buffer, std::size_t offset, double value) {
+            uint64_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            ClientServerChannelSpace::FixedCodec::store<uint64_t>(buffer, offset, bits);
+        }
+
+        void WriteBlock(Table &table);
+
+        template <typename T>
+        void Write(T value) {
+            char buffer[sizeof(T)];
+            Store(buffer, 0, value);
+            m_out.write(buffer, sizeof(T));
+        }
+
+        void WriteString(const std::string &value);
+
+        std::ofstream m_out;
+        std::vector<char> m_fileBuffer;
+        std::vector<Table> m_tables;
+        uint32_t m_blockRows;
+        std::chrono::steady_clock::duration m_flushInterval;
+        std::chrono::steady_clock::time_point m_nextFlush;
+        uint64_t m_appends = 0;
+    };
+}
+#endif
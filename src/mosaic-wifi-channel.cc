@@ -0,0 +1,313 @@
+/*
+ * Copyright (c) 2020 Fraunhofer FOKUS and others. All rights reserved.
+ *
+ * Contact: mosaic@fokus.fraunhofer.de
+ *
+ * This class is developed for the MOSAIC-NS-3 coupling.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "mosaic-wifi-channel.h"
+
+#include "mosaic-wifi-phy.h"
+#include "ns3/double.h"
+#include "ns3/log.h"
+#include "ns3/mobility-model.h"
+#include "ns3/net-device.h"
+#include "ns3/node.h"
+#include "ns3/pointer.h"
+#include "ns3/simulator.h"
+#include "ns3/wifi-utils.h"
+#include "ns3/boolean.h"
+#include "ns3/uinteger.h"
+
+#include <algorithm>
+#include <cmath>
+
+NS_LOG_COMPONENT_DEFINE("MosaicWifiChannel");
+
+namespace ns3 {
+
+    NS_OBJECT_ENSURE_REGISTERED(MosaicWifiChannel);
+
+    TypeId MosaicWifiChannel::GetTypeId(void) {
+        static TypeId tid = TypeId("ns3::MosaicWifiChannel")
+                .SetParent<Channel>()
+                .AddConstructor<MosaicWifiChannel>()
+                .AddAttribute("CutoffRange", "Maximum distance in meters a transmission is delivered to, 0 delivers to all phys",
+                DoubleValue(3000.0),
+                MakeDoubleAccessor(&MosaicWifiChannel::m_cutoffRange),
+                MakeDoubleChecker<double>(0.0))
+                .AddAttribute("CellSize", "Edge length in meters of a cell of the spatial index",
+                DoubleValue(250.0),
+                MakeDoubleAccessor(&MosaicWifiChannel::SetCellSize, &MosaicWifiChannel::GetCellSize),
+                MakeDoubleChecker<double>(1.0))
+                .AddAttribute("PropagationLossModel", "A pointer to the propagation loss model attached to this channel.",
+                PointerValue(),
+                MakePointerAccessor(&MosaicWifiChannel::m_loss),
+                MakePointerChecker<PropagationLossModel>())
+                .AddAttribute("PropagationDelayModel", "A pointer to the propagation delay model attached to this channel.",
+                PointerValue(),
+                MakePointerAccessor(&MosaicWifiChannel::m_delay),
+                MakePointerChecker<PropagationDelayModel>())
+                .AddAttribute("BatchEvaluation", "Evaluate loss and delay of all receivers of a transmission in one batch, "
+                "if the propagation models have a supported closed form (Friis loss, constant speed delay)",
+                BooleanValue(true),
+                MakeBooleanAccessor(&MosaicWifiChannel::m_batchEvaluation),
+                MakeBooleanChecker())
+                .AddAttribute("ParallelThreshold", "Minimum number of receivers of a batch to split it across threads",
+                UintegerValue(256),
+                MakeUintegerAccessor(&MosaicWifiChannel::m_parallelThreshold),
+                MakeUintegerChecker<uint32_t>())
+                .AddAttribute("Threads", "Number of threads for the batch evaluation, 0 uses the hardware concurrency",
+                UintegerValue(0),
+                MakeUintegerAccessor(&MosaicWifiChannel::m_numThreads),
+                MakeUintegerChecker<uint32_t>());
+        return tid;
+    }
+
+    MosaicWifiChannel::MosaicWifiChannel() : m_cutoffRange(3000.0), m_batchEvaluation(true), m_parallelThreshold(256), m_numThreads(0) {
+    }
+
+    void MosaicWifiChannel::DoDispose(void) {
+        m_phys.clear();
+        m_loss = nullptr;
+        m_delay = nullptr;
+        m_batch.Clear();
+        m_threadPool.reset();
+        m_receptionEnds = decltype(m_receptionEnds)();
+        Channel::DoDispose();
+    }
+
+    std::size_t MosaicWifiChannel::GetNDevices(void) const {
+        return m_phys.size();
+    }
+
+    Ptr<NetDevice> MosaicWifiChannel::GetDevice(std::size_t i) const {
+        auto it = m_phys.begin();
+        std::advance(it, i);
+        return it->second->GetDevice()->GetObject<NetDevice>();
+    }
+
+    void MosaicWifiChannel::Add(Ptr<MosaicWifiPhy> phy) {
+        m_phys[GetNodeId(phy)] = phy;
+    }
+
+    void MosaicWifiChannel::Remove(Ptr<MosaicWifiPhy> phy) {
+        uint32_t nodeId = GetNodeId(phy);
+        auto it = m_phys.find(nodeId);
+        if (it == m_phys.end() || it->second != phy) {
+            return;
+        }
+        m_phys.erase(it);
+        m_grid.Remove(nodeId);
+        NS_LOG_INFO("Removed phy of node " << nodeId << ", " << m_phys.size() << " phys left on channel");
+    }
+
+    void MosaicWifiChannel::UpdatePosition(uint32_t nodeId, const Vector &position) {
+        if (m_phys.find(nodeId) == m_phys.end()) {
+            return;
+        }
+        m_grid.Update(nodeId, position);
+    }
+
+    void MosaicWifiChannel::SetPropagationLossModel(const Ptr<PropagationLossModel> loss) {
+        m_loss = loss;
+        UpdateBatchSupport();
+    }
+
+    void MosaicWifiChannel::SetPropagationDelayModel(const Ptr<PropagationDelayModel> delay) {
+        m_delay = delay;
+        UpdateBatchSupport();
+    }
+
+    void MosaicWifiChannel::UpdateBatchSupport(void) {
+        m_batchSupported = false;
+        Ptr<FriisPropagationLossModel> friis = DynamicCast<FriisPropagationLossModel> (m_loss);
+        Ptr<ConstantSpeedPropagationDelayModel> constantSpeed = DynamicCast<ConstantSpeedPropagationDelayModel> (m_delay);
+        // chained loss models are evaluated one by one, so only a single Friis model has a closed form
+        if (friis == nullptr || friis->GetNext() != nullptr || constantSpeed == nullptr) {
+            return;
+        }
+        DoubleValue frequency;
+        DoubleValue systemLoss;
+        DoubleValue minLoss;
+        friis->GetAttribute("Frequency", frequency);
+        friis->GetAttribute("SystemLoss", systemLoss);
+        friis->GetAttribute("MinLoss", minLoss);
+        static const double C = 299792458.0; // speed of light in vacuum, as used by the Friis model
+        m_friisLambda = C / frequency.Get();
+        m_friisSystemLoss = systemLoss.Get();
+        m_friisMinLoss = minLoss.Get();
+        m_delaySpeed = constantSpeed->GetSpeed();
+        m_batchSupported = true;
+    }
+
+    void MosaicWifiChannel::Send(Ptr<MosaicWifiPhy> sender, Ptr<const Packet> packet, double txPowerDbm, Time duration) const {
+        NS_LOG_FUNCTION(this << sender << packet << txPowerDbm << duration.GetSeconds());
+        Ptr<MobilityModel> senderMobility = sender->GetMobility();
+        NS_ASSERT(senderMobility != 0);
+
+        m_grid.Query(senderMobility->GetPosition(), m_cutoffRange, m_receivers);
+        NS_LOG_DEBUG(m_receivers.size() << " of " << m_phys.size() << " phys within cutoff range of the sender");
+        // keeps the queue at the receptions in flight even if the lookahead is never queried
+        DropPastReceptionEnds();
+
+        // Pack the receivers in the order of their node ids, the receive events are scheduled in
+        // this order afterwards, independent of how the evaluation was split across threads
+        m_batch.Clear();
+        for (uint32_t nodeId : m_receivers) {
+            Ptr<MosaicWifiPhy> receiver = m_phys.at(nodeId);
+            if (receiver == sender) {
+                continue;
+            }
+            // For now don't account for inter channel interference nor channel bonding
+            if (receiver->GetChannelNumber() != sender->GetChannelNumber()) {
+                continue;
+            }
+            m_batch.phys.push_back(receiver);
+            m_batch.nodeIds.push_back(nodeId);
+        }
+        const std::size_t numReceivers = m_batch.phys.size();
+        m_batch.Resize(numReceivers);
+
+        if (m_batchEvaluation && m_batchSupported) {
+            for (std::size_t i = 0; i < numReceivers; i++) {
+                const Vector position = m_batch.phys[i]->GetMobility()->GetPosition();
+                m_batch.x[i] = position.x;
+                m_batch.y[i] = position.y;
+                m_batch.z[i] = position.z;
+            }
+            EvaluateBatch(senderMobility->GetPosition(), txPowerDbm);
+        } else {
+            for (std::size_t i = 0; i < numReceivers; i++) {
+                Ptr<MobilityModel> receiverMobility = m_batch.phys[i]->GetMobility()->GetObject<MobilityModel>();
+                m_batch.delaySeconds[i] = m_delay->GetDelay(senderMobility, receiverMobility).GetSeconds();
+                m_batch.rxPowerDbm[i] = m_loss->CalcRxPower(txPowerDbm, senderMobility, receiverMobility);
+            }
+        }
+
+        for (std::size_t i = 0; i < numReceivers; i++) {
+            NS_LOG_DEBUG("propagation: txPower=" << txPowerDbm << "dbm, rxPower=" << m_batch.rxPowerDbm[i] << "dbm, "
+                    << "receiver=" << m_batch.nodeIds[i] << ", delay=" << m_batch.delaySeconds[i] << "s");
+            Ptr<Packet> copy = packet->Copy();
+            Simulator::ScheduleWithContext(m_batch.nodeIds[i], Seconds(m_batch.delaySeconds[i]), &MosaicWifiChannel::Receive,
+                    m_batch.phys[i], copy, m_batch.rxPowerDbm[i], duration);
+            // the phy reports the frame at the end of its reception
+            m_receptionEnds.push(Simulator::Now() + Seconds(m_batch.delaySeconds[i]) + duration);
+        }
+    }
+
+    Time MosaicWifiChannel::GetNextReceptionEnd(void) const {
+        DropPastReceptionEnds();
+        return m_receptionEnds.empty() ? Time::Max() : m_receptionEnds.top();
+    }
+
+    void MosaicWifiChannel::DropPastReceptionEnds(void) const {
+        // a reception ending now may not have been processed yet, so only older ones are dropped
+        while (!m_receptionEnds.empty() && m_receptionEnds.top() < Simulator::Now()) {
+            m_receptionEnds.pop();
+        }
+    }
+
+    void MosaicWifiChannel::EvaluateBatch(const Vector &sender, double txPowerDbm) const {
+        const std::size_t numReceivers = m_batch.phys.size();
+        if (numReceivers < m_parallelThreshold) {
+            EvaluateBatchRange(0, numReceivers, sender, txPowerDbm);
+            return;
+        }
+        if (!m_threadPool) {
+            m_threadPool.reset(new MosaicThreadPool(m_numThreads));
+            NS_LOG_INFO("Started " << m_threadPool->GetNThreads() << " threads for the propagation evaluation");
+        }
+        m_threadPool->ParallelFor(numReceivers, [this, &sender, txPowerDbm](std::size_t begin, std::size_t end) {
+            EvaluateBatchRange(begin, end, sender, txPowerDbm);
+        });
+    }
+
+    void MosaicWifiChannel::EvaluateBatchRange(std::size_t begin, std::size_t end, const Vector &sender, double txPowerDbm) const {
+        // Same arithmetic as FriisPropagationLossModel and ConstantSpeedPropagationDelayModel,
+        // so the batch yields exactly the values of the per receiver evaluation
+        const double numerator = m_friisLambda * m_friisLambda;
+        const double *x = m_batch.x.data();
+        const double *y = m_batch.y.data();
+        const double *z = m_batch.z.data();
+        double *rxPowerDbm = m_batch.rxPowerDbm.data();
+        double *delaySeconds = m_batch.delaySeconds.data();
+        for (std::size_t i = begin; i < end; i++) {
+            const double dx = sender.x - x[i];
+            const double dy = sender.y - y[i];
+            const double dz = sender.z - z[i];
+            const double distance = std::sqrt(dx * dx + dy * dy + dz * dz);
+            delaySeconds[i] = distance / m_delaySpeed;
+            if (distance <= 0) {
+                rxPowerDbm[i] = txPowerDbm - m_friisMinLoss;
+                continue;
+            }
+            const double denominator = 16 * M_PI * M_PI * distance * distance * m_friisSystemLoss;
+            const double lossDb = -10 * std::log10(numerator / denominator);
+            rxPowerDbm[i] = txPowerDbm - std::max(lossDb, m_friisMinLoss);
+        }
+    }
+
+    void MosaicWifiChannel::Receive(Ptr<MosaicWifiPhy> receiver, Ptr<Packet> packet, double rxPowerDbm, Time duration) {
+        NS_LOG_FUNCTION(receiver << packet << rxPowerDbm << duration.GetSeconds());
+        // The phy may have been removed from the channel while the frame was in flight
+        if (receiver->GetChannel() == nullptr) {
+            return;
+        }
+        // Do no further processing if signal is too weak
+        // Current implementation assumes constant rx power over the packet duration
+        if ((rxPowerDbm + receiver->GetRxGain()) < receiver->GetEdThreshold()) {
+            NS_LOG_INFO("Received signal too weak to process: " << rxPowerDbm << " dBm");
+            return;
+        }
+        receiver->StartReceivePreamble(packet, DbmToW(rxPowerDbm + receiver->GetRxGain()), duration);
+    }
+
+    int64_t MosaicWifiChannel::AssignStreams(int64_t stream) {
+        int64_t currentStream = stream;
+        currentStream += m_loss->AssignStreams(stream);
+        return (currentStream - stream);
+    }
+
+    uint32_t MosaicWifiChannel::GetNodeId(Ptr<MosaicWifiPhy> phy) {
+        Ptr<NetDevice> device = phy->GetDevice()->GetObject<NetDevice>();
+        NS_ASSERT_MSG(device != nullptr, "phy has to be attached to a device before it is added to the channel");
+        return device->GetNode()->GetId();
+    }
+
+    void MosaicWifiChannel::Batch::Clear(void) {
+        phys.clear();
+        nodeIds.clear();
+    }
+
+    void MosaicWifiChannel::Batch::Resize(std::size_t n) {
+        x.resize(n);
+        y.resize(n);
+        z.resize(n);
+        rxPowerDbm.resize(n);
+        delaySeconds.resize(n);
+    }
+
+    double MosaicWifiChannel::GetCellSize(void) const {
+        return m_grid.GetCellSize();
+    }
+
+    void MosaicWifiChannel::SetCellSize(double cellSize) {
+        m_grid.SetCellSize(cellSize);
+    }
+}
@@ -0,0 +1,179 @@
+/*
+ * Copyright (c) 2020 Fraunhofer FOKUS and others. All rights reserved.
+ *
+ * Contact: mosaic@fokus.fraunhofer.de
+ *
+ * This class is developed for the MOSAIC-NS-3 coupling.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef MOSAIC_WIFI_CHANNEL_H
+#define MOSAIC_WIFI_CHANNEL_H
+
+#include <map>
+#include <functional>
+#include <memory>
+#include <queue>
+#include <vector>
+
+#include "ns3/channel.h"
+#include "ns3/nstime.h"
+#include "ns3/packet.h"
+#include "ns3/propagation-delay-model.h"
+#include "ns3/propagation-loss-model.h"
+#include "mosaic-spatial-grid.h"
+#include "mosaic-thread-pool.h"
+
+namespace ns3 {
+
+    class MosaicWifiPhy;
+
+    /**
+     * @class MosaicWifiChannel
+     * @brief Wifi channel of the federate, behaves like the YansWifiChannel but keeps
+     * the attached phys in a uniform grid. A transmission is only delivered to the phys
+     * within the configured cutoff range of the sender, instead of fanning out to every
+     * phy on the channel. Phys can be removed again, e.g. when MOSAIC removes a node.
+     */
+    class MosaicWifiChannel : public Channel {
+    public:
+        static TypeId GetTypeId(void);
+
+        MosaicWifiChannel();
+        virtual ~MosaicWifiChannel() = default;
+
+        virtual std::size_t GetNDevices(void) const;
+        virtual Ptr<NetDevice> GetDevice(std::size_t i) const;
+
+        /**
+         * @brief add a phy to the channel, it is indexed once its position is known
+         *
+         * @param phy the phy to add, it must already be attached to its device
+         */
+        void Add(Ptr<MosaicWifiPhy> phy);
+
+        /**
+         * @brief remove a phy from the channel and the spatial index
+         *
+         * @param phy the phy to remove
+         */
+        void Remove(Ptr<MosaicWifiPhy> phy);
+
+        /**
+         * @brief update the position of a node in the spatial index
+         *
+         * @param nodeId ns-3 id of the node owning the phy
+         * @param position the new position
+         */
+        void UpdatePosition(uint32_t nodeId, const Vector &position);
+
+        void SetPropagationLossModel(const Ptr<PropagationLossModel> loss);
+        void SetPropagationDelayModel(const Ptr<PropagationDelayModel> delay);
+
+        /**
+         * @brief deliver a frame to all phys within the cutoff range of the sender
+         *
+         * @param sender the phy which sends the frame
+         * @param packet the frame
+         * @param txPowerDbm the tx power including the antenna gain
+         * @param duration the duration of the frame
+         */
+        void Send(Ptr<MosaicWifiPhy> sender, Ptr<const Packet> packet, double txPowerDbm, Time duration) const;
+
+        /**
+         * @brief end of the earliest reception which is still in flight, Time::Max() if there is none
+         */
+        Time GetNextReceptionEnd(void) const;
+
+        int64_t AssignStreams(int64_t stream);
+
+    private:
+        virtual void DoDispose(void);
+
+        static void Receive(Ptr<MosaicWifiPhy> receiver, Ptr<Packet> packet, double rxPowerDbm, Time duration);
+
+        static uint32_t GetNodeId(Ptr<MosaicWifiPhy> phy);
+
+        /**
+         * @brief check whether the configured models have a closed form the batch evaluation supports
+         */
+        void UpdateBatchSupport(void);
+
+        /**
+         * @brief drop the ends of the receptions which are over
+         */
+        void DropPastReceptionEnds(void) const;
+
+        /**
+         * @brief compute rx power and delay for all receivers in m_batch at once
+         *
+         * @param sender position of the sender
+         * @param txPowerDbm the tx power including the antenna gain
+         */
+        void EvaluateBatch(const Vector &sender, double txPowerDbm) const;
+
+        /**
+         * @brief closed form of the propagation models for the receivers in [begin, end)
+         */
+        void EvaluateBatchRange(std::size_t begin, std::size_t end, const Vector &sender, double txPowerDbm) const;
+
+        double GetCellSize(void) const;
+        void SetCellSize(double cellSize);
+
+        std::map<uint32_t, Ptr<MosaicWifiPhy>> m_phys;
+        MosaicSpatialGrid m_grid;
+        double m_cutoffRange;
+        Ptr<PropagationLossModel> m_loss;
+        Ptr<PropagationDelayModel> m_delay;
+
+        // scratch buffer of the receivers of the current transmission, kept to avoid reallocations
+        mutable std::vector<uint32_t> m_receivers;
+
+        // end times of the scheduled receptions, the ones in the past are dropped on every send and query
+        mutable std::priority_queue<Time, std::vector<Time>, std::greater<Time>> m_receptionEnds;
+
+        bool m_batchEvaluation;
+        uint32_t m_parallelThreshold;
+        uint32_t m_numThreads;
+        mutable std::unique_ptr<MosaicThreadPool> m_threadPool;
+
+        // constants of the closed form models, only valid if m_batchSupported is set
+        bool m_batchSupported = false;
+        double m_friisLambda = 0.0;
+        double m_friisSystemLoss = 1.0;
+        double m_friisMinLoss = 0.0;
+        double m_delaySpeed = 0.0;
+
+        /**
+         * Receivers of one transmission as structure of arrays, so the evaluation
+         * loop is vectorizable and can be split across threads.
+         */
+        struct Batch {
+            std::vector<Ptr<MosaicWifiPhy>> phys;
+            std::vector<uint32_t> nodeIds;
+            std::vector<double> x;
+            std::vector<double> y;
+            std::vector<double> z;
+            std::vector<double> rxPowerDbm;
+            std::vector<double> delaySeconds;
+
+            void Clear(void);
+            void Resize(std::size_t n);
+        };
+        mutable Batch m_batch;
+    };
+}
+#endif
@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2020 Fraunhofer FOKUS and others. All rights reserved.
+ *
+ * Contact: mosaic@fokus.fraunhofer.de
+ *
+ * This class is developed for the MOSAIC-NS-3 coupling.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "mosaic-wifi-phy.h"
+
+#include "mosaic-wifi-channel.h"
+#include "ns3/error-rate-model.h"
+#include "ns3/log.h"
+
+NS_LOG_COMPONENT_DEFINE("MosaicWifiPhy");
+
+namespace ns3 {
+
+    NS_OBJECT_ENSURE_REGISTERED(MosaicWifiPhy);
+
+    TypeId MosaicWifiPhy::GetTypeId(void) {
+        static TypeId tid = TypeId("ns3::MosaicWifiPhy")
+                .SetParent<YansWifiPhy>()
+                .AddConstructor<MosaicWifiPhy>();
+        return tid;
+    }
+
+    void MosaicWifiPhy::SetMosaicChannel(Ptr<MosaicWifiChannel> channel) {
+        DetachMosaicChannel();
+        m_mosaicChannel = channel;
+        m_mosaicChannel->Add(this);
+    }
+
+    void MosaicWifiPhy::DetachMosaicChannel(void) {
+        if (m_mosaicChannel != nullptr) {
+            m_mosaicChannel->Remove(this);
+            m_mosaicChannel = nullptr;
+        }
+    }
+
+    void MosaicWifiPhy::StartTx(Ptr<Packet> packet, WifiTxVector txVector, Time txDuration) {
+        NS_LOG_DEBUG("Start transmission: signal power before antenna gain=" << GetPowerDbm(txVector.GetTxPowerLevel()) << "dBm");
+        if (m_mosaicChannel == nullptr) {
+            NS_LOG_WARN("Phy is not attached to a channel, dropping transmission");
+            return;
+        }
+        m_mosaicChannel->Send(this, packet, GetPowerDbm(txVector.GetTxPowerLevel()) + GetTxGain(), txDuration);
+    }
+
+    Ptr<Channel> MosaicWifiPhy::GetChannel(void) const {
+        return m_mosaicChannel;
+    }
+
+    void MosaicWifiPhy::DoDispose(void) {
+        m_mosaicChannel = nullptr;
+        YansWifiPhy::DoDispose();
+    }
+
+    MosaicWifiPhyHelper::MosaicWifiPhyHelper() {
+        m_phy.SetTypeId("ns3::MosaicWifiPhy");
+    }
+
+    MosaicWifiPhyHelper MosaicWifiPhyHelper::Default(void) {
+        MosaicWifiPhyHelper helper;
+        helper.SetErrorRateModel("ns3::NistErrorRateModel");
+        return helper;
+    }
+
+    void MosaicWifiPhyHelper::SetChannel(Ptr<MosaicWifiChannel> channel) {
+        m_mosaicChannel = channel;
+    }
+
+    Ptr<WifiPhy> MosaicWifiPhyHelper::Create(Ptr<Node> node, Ptr<NetDevice> device) const {
+        Ptr<MosaicWifiPhy> phy = m_phy.Create<MosaicWifiPhy>();
+        Ptr<ErrorRateModel> error = m_errorRateModel.Create<ErrorRateModel>();
+        phy->SetErrorRateModel(error);
+        phy->SetDevice(device);
+        if (m_mosaicChannel != nullptr) {
+            phy->SetMosaicChannel(m_mosaicChannel);
+        } else {
+            NS_LOG_ERROR("No MosaicWifiChannel set, created phy will not be able to communicate");
+        }
+        return phy;
+    }
+}
@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2020 Fraunhofer FOKUS and others. All rights reserved.
+ *
+ * Contact: mosaic@fokus.fraunhofer.de
+ *
+ * This class is developed for the MOSAIC-NS-3 coupling.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef MOSAIC_WIFI_PHY_H
+#define MOSAIC_WIFI_PHY_H
+
+#include "ns3/yans-wifi-phy.h"
+#include "ns3/yans-wifi-helper.h"
+
+namespace ns3 {
+
+    class MosaicWifiChannel;
+
+    /**
+     * @class MosaicWifiPhy
+     * @brief A YansWifiPhy which transmits over a MosaicWifiChannel.
+     * YansWifiChannel does not allow to intercept Send() or to remove a phy once it
+     * was added, hence the phy itself hands its frames to the federate provided channel.
+     * Reception and all other PHY behaviour are inherited unchanged.
+     */
+    class MosaicWifiPhy : public YansWifiPhy {
+    public:
+        static TypeId GetTypeId(void);
+
+        MosaicWifiPhy() = default;
+        virtual ~MosaicWifiPhy() = default;
+
+        /**
+         * @brief attach this phy to the given channel, replaces a previously attached channel
+         *
+         * @param channel the channel to transmit on
+         */
+        void SetMosaicChannel(Ptr<MosaicWifiChannel> channel);
+
+        /**
+         * @brief detach this phy from its channel, it will neither send nor receive anymore
+         */
+        void DetachMosaicChannel(void);
+
+        virtual void StartTx(Ptr<Packet> packet, WifiTxVector txVector, Time txDuration);
+        virtual Ptr<Channel> GetChannel(void) const;
+
+    protected:
+        virtual void DoDispose(void);
+
+    private:
+        Ptr<MosaicWifiChannel> m_mosaicChannel;
+    };
+
+    /**
+     * @class MosaicWifiPhyHelper
+     * @brief Creates MosaicWifiPhy instances and attaches them to a MosaicWifiChannel.
+     * The helper is a drop-in replacement of YansWifiPhyHelper for Wifi80211pHelper::Install.
+     */
+    class MosaicWifiPhyHelper : public YansWifiPhyHelper {
+    public:
+        MosaicWifiPhyHelper();
+
+        /**
+         * @brief create a phy helper in a default working state, like YansWifiPhyHelper::Default()
+         */
+        static MosaicWifiPhyHelper Default(void);
+
+        void SetChannel(Ptr<MosaicWifiChannel> channel);
+
+        virtual Ptr<WifiPhy> Create(Ptr<Node> node, Ptr<NetDevice> device) const;
+
+    private:
+        Ptr<MosaicWifiChannel> m_mosaicChannel;
+    };
+}
+#endif
@@ -22,26 +22,20 @@
 
 #include <exception>
 #include <string>
+#include <vector>
 #include <unistd.h>
 
 #include "ns3/log.h"
 #include "ns3/core-module.h"
 #include "mosaic-ns3-server.h"
-#include "ns3/config-store.h"
+#include "mosaic-logger.h"
 
 #include <algorithm>
-#include <libxml2/libxml/xpath.h>
-#include <libxml2/libxml/tree.h>
 
 using namespace ns3;
 
 NS_LOG_COMPONENT_DEFINE("MosaicStarter");
 
-struct NetworkConfig {
-    std::string commType;
-    int numOfNodes;
-};
-
 static LogLevel ParseLogLevel(const std::string & levelString) {
     //Taken from ns-3 environment parsing of log level
     unsigned int level = 0;
@@ -103,102 +97,43 @@ static LogLevel ParseLogLevel(const std::string & levelString) {
     return (LogLevel) level;
 }
 
-void SetLogLevels(const std::string & configFile) {
-    xmlChar *xpath = (xmlChar *) "//ns3/LogLevel/component";
-    xmlDocPtr doc = xmlParseFile(configFile.c_str());
-    xmlXPathContextPtr context = xmlXPathNewContext(doc);
-    xmlXPathObjectPtr result = xmlXPathEvalExpression(xpath, context);
-
-    std::string componentString;
-    std::string levelString;
-    for (int i = 0; result->nodesetval != nullptr && i < result->nodesetval->nodeNr; i++) {
-        
-        xmlNodePtr nodePtr = result->nodesetval->nodeTab[i];
-        for (xmlAttrPtr attr = nodePtr->properties; NULL != attr; attr = attr->next) {
-            std::string attrName((char *) attr->name);
-            
-            if (attrName == "name") {
-                componentString.assign((char *) xmlNodeListGetString(doc, attr->children, 1));
-            } else if (attrName == "value") {
-                levelString.assign((char *) xmlNodeListGetString(doc, attr->children, 1));
-            }
-        }
-        
-        if (componentString == "" || levelString == "") {
-            std::cerr << "Could not parse log level for component [" << componentString << "], level [" << levelString << "]" << std::endl;
-            continue;
-        }
-
+void SetLogLevels(const std::vector<LogLevelConfig> &logLevels) {
+    for (const LogLevelConfig &logLevel : logLevels) {
+        std::string levelString = logLevel.level;
         std::transform(levelString.begin(), levelString.end(), levelString.begin(),
                 [](unsigned char c) -> unsigned char {
                     return std::tolower(c); });
+
+        // the hot paths log through the asynchronous MosaicLogger instead of NS_LOG
+        if (logLevel.component == "MosaicLogger" || logLevel.component == "*") {
+            MosaicLogger::SetLevel(MosaicLogger::ParseLevel(levelString));
+            if (logLevel.component == "MosaicLogger") {
+                continue;
+            }
+        }
         LogLevel level = ParseLogLevel(levelString);
         
-        if (componentString == "*") {
+        if (logLevel.component == "*") {
             LogComponentEnableAll(level);
         } else {
-            LogComponentEnable(componentString.c_str(), level);
+            LogComponentEnable(logLevel.component.c_str(), level);
         }        
     }
-
-    xmlXPathFreeObject(result);
 }
 
-std::string GetCommType(const std::string &configFile) {
-    xmlDocPtr doc = xmlParseFile(configFile.c_str());
-    xmlXPathContextPtr context = xmlXPathNewContext(doc);
-
-    // XPath to find the specific CommType component
-    xmlChar *xpath = (xmlChar *) "//ns3/NetworkConfig/component[@name='CommType']";
-    xmlXPathObjectPtr result = xmlXPathEvalExpression(xpath, context);
-
-    std::string valueString;
-    if (result && result->nodesetval && result->nodesetval->nodeNr > 0) {
-        xmlNodePtr nodePtr = result->nodesetval->nodeTab[0]; // First (and should be only) node
-
-        for (xmlAttrPtr attr = nodePtr->properties; attr != nullptr; attr = attr->next) {
-            std::string attrName((char *) attr->name);
-            if (attrName == "value") {
-                valueString.assign((char *) xmlNodeListGetString(doc, attr->children, 1));
-                break; // Once value is found, break the loop
-            }
-        }
+/**
+ * @brief apply the attribute settings like the ConfigStore in load mode would
+ */
+void SetAttributes(const FederateConfig &config) {
+    for (const AttributeConfig &setting : config.defaults) {
+        Config::SetDefaultFailSafe(setting.name, StringValue(setting.value));
     }
-
-    xmlXPathFreeObject(result);
-    xmlFreeDoc(doc);
-    xmlCleanupParser();
-
-    return valueString;
-}
-
-int GetNumOfNodes(const std::string &configFile) {
-    xmlDocPtr doc = xmlParseFile(configFile.c_str());
-    xmlXPathContextPtr context = xmlXPathNewContext(doc);
-
-    // XPath to find the specific NumOfNodes component
-    xmlChar *xpath = (xmlChar *) "//NetworkConfig/component[@name='NumOfNodes']";
-    xmlXPathObjectPtr result = xmlXPathEvalExpression(xpath, context);
-
-    int numOfNodes = 0;
-    if (result && result->nodesetval && result->nodesetval->nodeNr > 0) {
-        xmlNodePtr nodePtr = result->nodesetval->nodeTab[0]; // First (and should be only) node
-
-        for (xmlAttrPtr attr = nodePtr->properties; attr != nullptr; attr = attr->next) {
-            std::string attrName((char *) attr->name);
-            if (attrName == "value") {
-                std::string valueString = (char *) xmlNodeListGetString(doc, attr->children, 1);
-                numOfNodes = std::atoi(valueString.c_str());
-                break; // Once value is found, break the loop
-            }
-        }
+    for (const AttributeConfig &setting : config.globals) {
+        Config::SetGlobalFailSafe(setting.name, StringValue(setting.value));
+    }
+    for (const AttributeConfig &setting : config.values) {
+        Config::Set(setting.name, StringValue(setting.value));
     }
-
-    xmlXPathFreeObject(result);
-    xmlFreeDoc(doc);
-    xmlCleanupParser();
-
-    return numOfNodes;
 }
 
 int main(int argc, char *argv[]) {
@@ -224,34 +159,21 @@ int main(int argc, char *argv[]) {
         return -1;
     }
 
-    Config::SetDefault("ns3::ConfigStore::Filename", StringValue(configFile.c_str()));
-    Config::SetDefault("ns3::ConfigStore::FileFormat", StringValue("Xml"));
-    Config::SetDefault("ns3::ConfigStore::Mode", StringValue("Load"));
-    ConfigStore xmlConfig;
-
-    xmlConfig.ConfigureDefaults();
-    xmlConfig.ConfigureAttributes();
-
-    SetLogLevels(configFile);
-    
-    NetworkConfig config;
-    config.commType = GetCommType(configFile);
+    FederateConfig config;
+    if (!LoadFederateConfig(configFile, config)) {
+        return -1;
+    }
+    SetAttributes(config);
+    SetLogLevels(config.logLevels);
 
+    if (config.commType != CommunicationType::DSRC && config.commType != CommunicationType::LTE
+            && config.commType != CommunicationType::ANALYTICAL) {
+        NS_LOG_ERROR("Unknown communication type:" << config.commType);
+        return 0;
+    }
 
     try {
-        MosaicNs3Server server(port, cmdPort, config.commType);
-        if (config.commType == "LTE"){
-            config.numOfNodes = GetNumOfNodes(configFile);
-            server.SetNumOfNodes(config.numOfNodes);
-        }
-        else if (config.commType == "DSRC"){
-            // do nothing
-        }
-        else{
-            NS_LOG_ERROR("Unknown communication type:" << config.commType);
-            return 0;
-        }
-            
+        MosaicNs3Server server(port, cmdPort, config);
         server.processCommandsUntilSimStep();
     } catch (int e) {
         NS_LOG_ERROR("Caught exception [" << e << "]. Exiting ns-3 federate ");
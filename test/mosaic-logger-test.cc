@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2020 Fraunhofer FOKUS and others. All rights reserved.
+ *
+ * Contact: mosaic@fokus.fraunhofer.de
+ *
+ * This class is developed for the MOSAIC-NS-3 coupling.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+
+/**
+ * Checks that MosaicLogger truncates string arguments to the text buffer of a record.
+ * Logs strings longer than the buffer, alone and after other strings which already
+ * filled it, and verifies the printed lines. stderr is redirected to a temporary file
+ * while the records are drained. Returns a non zero exit code on failure.
+ *
+ * usage: mosaic-logger-test
+ */
+
+#include "mosaic-logger.h"
+
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using namespace ns3;
+
+namespace {
+
+    int g_failures = 0;
+
+    void Check(bool condition, const std::string &name) {
+        if (!condition) {
+            std::cout << "FAIL: " << name << std::endl;
+            g_failures++;
+        }
+    }
+
+    std::vector<std::string> ReadLines(FILE *file) {
+        std::vector<std::string> lines;
+        std::rewind(file);
+        std::string line;
+        int c;
+        while ((c = std::fgetc(file)) != EOF) {
+            if (c == '\n') {
+                lines.push_back(line);
+                line.clear();
+            } else {
+                line.push_back(static_cast<char> (c));
+            }
+        }
+        return lines;
+    }
+}
+
+int main() {
+    const std::size_t textSize = MosaicLogger::TEXT_SIZE;
+    const std::string longText(textSize + 40, 'a');
+    const std::string otherText(2 * textSize, 'b');
+
+    FILE *capture = std::tmpfile();
+    std::fflush(stderr);
+    const int savedStderr = dup(fileno(stderr));
+    dup2(fileno(capture), fileno(stderr));
+
+    MosaicLogger::SetLevel(MOSAIC_LOG_LEVEL_DEBUG);
+    MosaicLogger &logger = MosaicLogger::Get();
+    // a single string longer than the buffer
+    logger.Write(MOSAIC_LOG_LEVEL_INFO, "[{}]", longText);
+    // the second string finds the buffer full
+    logger.Write(MOSAIC_LOG_LEVEL_INFO, "[{}][{}][{}]", longText, otherText, 7);
+    // the buffer is filled up to the terminator by the first string
+    logger.Write(MOSAIC_LOG_LEVEL_INFO, "[{}][{}]", std::string(textSize - 2, 'c'), otherText);
+    // short strings are untouched
+    logger.Write(MOSAIC_LOG_LEVEL_INFO, "[{}][{}]", std::string("x"), std::string("y"));
+    logger.Flush();
+
+    std::fflush(stderr);
+    dup2(savedStderr, fileno(stderr));
+    close(savedStderr);
+
+    const std::string truncated(textSize - 1, 'a');
+    const std::vector<std::string> lines = ReadLines(capture);
+    std::fclose(capture);
+
+    Check(lines.size() == 4, "four lines are printed");
+    if (lines.size() == 4) {
+        Check(lines[0].find("[" + truncated + "]") != std::string::npos, "long string is truncated");
+        Check(lines[1].find("[" + truncated + "][][7]") != std::string::npos, "string after a full buffer is empty");
+        Check(lines[2].find("[" + std::string(textSize - 2, 'c') + "][]") != std::string::npos, "string after the last free byte is empty");
+        Check(lines[3].find("[x][y]") != std::string::npos, "short strings are kept");
+    }
+
+    if (g_failures == 0) {
+        std::cout << "mosaic-logger-test: OK" << std::endl;
+    }
+    return g_failures == 0 ? 0 : 1;
+}